@@ -0,0 +1,54 @@
+# frozen_string_literal: true
+#
+# round-trip latency of attaching to, evaluating in and detaching from a
+# process, which is what every `rbtrace -e` or `rbtrace --backtraces`
+# invocation pays for.
+#
+# usage: ruby bench/attach_latency.rb [iterations]
+
+$LOAD_PATH.unshift File.expand_path('../../lib', __FILE__)
+$LOAD_PATH.unshift File.expand_path('../../ext', __FILE__)
+
+require 'rbtrace/rbtracer'
+
+iterations = Integer(ARGV.fetch(0, 50))
+
+tracee = spawn(RbConfig.ruby, '-I', File.expand_path('../../lib', __FILE__),
+                              '-I', File.expand_path('../../ext', __FILE__),
+                              '-r', 'rbtrace', '-e', 'loop { sleep 0.01 }')
+sleep 1 # let it boot
+
+# RBTracer reports progress on STDERR, which is just noise here
+stderr = STDERR.dup
+STDERR.reopen(File::NULL)
+
+clock = -> { Process.clock_gettime(Process::CLOCK_MONOTONIC) }
+times = Hash.new { |h, k| h[k] = [] }
+
+begin
+  iterations.times do
+    t0 = clock.()
+    tracer = RBTracer.new(tracee)
+    t1 = clock.()
+    tracer.eval('1 + 1')
+    t2 = clock.()
+    tracer.detach
+    t3 = clock.()
+
+    times[:attach] << t1 - t0
+    times[:eval] << t2 - t1
+    times[:detach] << t3 - t2
+    times[:total] << t3 - t0
+  end
+ensure
+  STDERR.reopen(stderr)
+  Process.kill('TERM', tracee)
+  Process.wait(tracee)
+end
+
+puts "%-8s %10s %10s %10s" % %w[phase p50(ms) p90(ms) max(ms)]
+times.each do |phase, samples|
+  samples.sort!
+  pct = ->(p) { samples[((samples.size - 1) * p).round] * 1000 }
+  puts "%-8s %10.3f %10.3f %10.3f" % [phase, pct.(0.5), pct.(0.9), samples.last * 1000]
+end
@@ -62,6 +62,12 @@ end
 have_func('rb_during_gc', 'ruby.h')
 have_func('rb_gc_add_event_hook', ['ruby.h', 'node.h'])
 have_func('rb_postponed_job_register_one', 'ruby.h')
+have_func('rb_thread_call_without_gvl', 'ruby/thread.h')
+have_func('rb_nogvl', 'ruby/thread.h')
+have_header('pthread.h')
+have_func('rb_profile_frames', 'ruby/debug.h')
+have_func('rb_profile_thread_frames', 'ruby/debug.h')
+have_func('rb_internal_thread_specific_get', 'ruby/thread.h')
 
 # warnings save lives
 $CFLAGS << " -Wall "
@@ -1,9 +1,20 @@
+#ifdef __linux__
+#define _GNU_SOURCE 1 // struct ucred, as ruby/config.h defines it
+#endif
+
 #include <assert.h>
+#include <ctype.h>
 #include <inttypes.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <fnmatch.h>
+#include <regex.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -13,10 +24,12 @@
 #include <sys/msg.h>
 #include <sys/resource.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/un.h>
 #include <sys/wait.h>
+#include <arpa/inet.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -24,6 +37,19 @@
 #include <ruby.h>
 #include <ruby/debug.h>
 
+#ifdef HAVE_RB_THREAD_CALL_WITHOUT_GVL
+#include <ruby/thread.h>
+#endif
+
+#if defined(HAVE_RB_POSTPONED_JOB_REGISTER_ONE) && defined(HAVE_RB_THREAD_CALL_WITHOUT_GVL)
+#define RBTRACE_WAKEUP_THREAD
+#endif
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#define RBTRACE_WRITER_THREAD
+#endif
+
 #ifndef RUBY_VM
 #include <env.h>
 #include <node.h>
@@ -49,6 +75,8 @@
  #define PLATFORM_FREEBSD
 #elif defined __OpenBSD__
  #define PLATFORM_OPENBSD
+#elif defined __linux__
+ #define PLATFORM_LINUX
 #endif
 
 
@@ -57,13 +85,21 @@
 #define SUN_LEN(ptr) ((size_t) (((struct sockaddr_un *) 0)->sun_path) + strlen((ptr)->sun_path))
 #endif
 
+// User and system time of the calling thread, or of the whole process where
+// threads have no clock of their own.
 static uint64_t
-ru_utime_usec()
+cputime_usec()
 {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return (uint64_t)ts.tv_sec*1000000 + ts.tv_nsec/1000;
+#endif
+
   struct rusage r_usage;
   getrusage(RUSAGE_SELF, &r_usage);
-  return (uint64_t)r_usage.ru_utime.tv_sec*1e6 +
-         (uint64_t)r_usage.ru_utime.tv_usec;
+  return (uint64_t)(r_usage.ru_utime.tv_sec + r_usage.ru_stime.tv_sec)*1000000 +
+         (uint64_t)(r_usage.ru_utime.tv_usec + r_usage.ru_stime.tv_usec);
 }
 
 static uint64_t
@@ -75,28 +111,58 @@ timeofday_usec()
          (uint64_t)tv.tv_usec;
 }
 
+#define RBTRACE_EVENTS_RUBY  (RUBY_EVENT_CALL   | RUBY_EVENT_RETURN)
+#define RBTRACE_EVENTS_CFUNC (RUBY_EVENT_C_CALL | RUBY_EVENT_C_RETURN)
+#define RBTRACE_EVENTS_ALL   (RBTRACE_EVENTS_RUBY | RBTRACE_EVENTS_CFUNC)
+
 #define MAX_CALLS 32768 // up to this many stack frames examined in slow watch mode
-#define MAX_TRACERS 100 // max method tracers
-#define MAX_EXPRS 10    // max expressions per tracer
+#define METRICS_STACK 64 // nested calls timed per thread for metrics
+#define MAX_KLASS_CACHE 4096 // classes cached per devmode tracer or pattern table
+#define MAX_STACK_FRAMES 128 // frames captured for each slow call
+#define MAX_STACKS 4096      // distinct slow call stacks remembered at once
+#define BACKTRACE_CHUNK 256  // frames per event when sending thread backtraces
+#define MAX_BACKTRACE 65536  // frames walked per thread at most
+#define EVAL_CHUNK 16384     // bytes of an eval result per event
+#define ADDALL_CHUNK 2048 // tracer ids per reply to a bulk add
 #ifndef BUF_SIZE        // msgq buffer size
 #define BUF_SIZE 1024
 #endif
 
+typedef struct {
+  char *pattern; // fnmatch() glob, or regex when is_regex. NULL matches anything
+  bool is_regex;
+  regex_t regex;
+} rbtracer_pattern_t;
+
 typedef struct {
   int id;
   char *query;
   bool is_slow;
 
+  // selectors with globs or regexes are matched by name, and only once per
+  // distinct (klass, mid) through rbtracer.pattern_tbl
+  bool is_pattern;
+  rbtracer_pattern_t klass_pattern;
+  rbtracer_pattern_t mid_pattern;
+
   char *klass_name;
   size_t klass_len;
   bool is_singleton;
+  st_table *klass_cache; // devmode: class VALUE -> klass_name matched
 
   VALUE self;
   VALUE klass;
   ID mid;
 
   int num_exprs;
-  char *exprs[MAX_EXPRS];
+  char **exprs;
+
+  unsigned int events; // call events the method can fire, see rbtracer__events()
+
+  // expressions are evaluated within rbtracer.expr_sample and expr_max_rate
+  uint64_t expr_calls;
+  uint64_t expr_second;
+  uint32_t expr_evals;
 } rbtracer_t;
 
 typedef struct {
@@ -110,32 +176,65 @@ static struct {
 
   pid_t attached_pid;
 
-  bool installed;
+  rb_event_hook_func_t hook; // installed event hook, specialized by mode
+  unsigned int hook_events;
   bool devmode;
+  unsigned long devmode_serial; // bumped on class/module definitions
+  unsigned long devmode_synced;
 
   bool gc;
   bool firehose;
 
   bool slow;
   bool slowcpu;
-  uint64_t call_times[MAX_CALLS];
-  uint64_t call_utimes[MAX_CALLS];
-  int num_calls;
+  bool cputime; // send cpu time along with slow calls and returns
+  bool threads; // send the current thread along with calls and returns
+  unsigned long calls_serial; // bumped to reset every thread's call stack
   uint32_t threshold;
 
   unsigned int num;
   unsigned int num_slow;
-  rbtracer_t list[MAX_TRACERS];
+  unsigned int num_patterns;
+  unsigned int num_ruby_events;  // tracers that can match ruby methods
+  unsigned int num_cfunc_events; // ... and c methods
+  unsigned int num_watched;      // tracers naming a single method, see method_watch_hook()
+  unsigned int list_size; // grows as needed, tracer ids index into it
+  rbtracer_t *list;
+
+  // limits on what evaluating expressions may cost, 0 for none
+  uint32_t expr_max_len;  // bytes of an inspected value
+  uint32_t expr_max_rate; // evaluations per second per tracer
+  uint32_t expr_sample;   // evaluate on one in this many calls
+
+  // class name -> VALUE, while resolving a batch of selectors
+  st_table *resolve_tbl;
+
+  // reassembly buffer for commands too large for a single msgq message
+  char *frag_buf;
+  size_t frag_len;
+  size_t frag_total;
+
+  // (klass|singleton) -> mid -> pattern tracer id+1, or 0 for no match
+  st_table *pattern_tbl;
+
+  // rbtrace_stack_t -> id, for stacks of slow calls already sent
+  st_table *stack_tbl;
+  int next_stack_id;
 
   key_t mqi_key;
   int mqi_id;
 
+  // control socket, used instead of the msgq where available
+  pid_t ctl_pid;
+  int ctl_listen_fd;
+  int ctl_fd;
+  char *ctl_buf;
+  size_t ctl_len;
+  size_t ctl_size;
+
   int mqo_fd;
   struct sockaddr_un mqo_addr;
   socklen_t mqo_len;
-
-  msgpack_sbuffer *sbuf;
-  msgpack_packer *msgpacker;
 }
 rbtracer = {
   .mid_tbl = NULL,
@@ -143,122 +242,328 @@ rbtracer = {
 
   .attached_pid = 0,
 
-  .installed = false,
+  .hook = NULL,
+  .hook_events = 0,
   .devmode = false,
+  .devmode_serial = 0,
+  .devmode_synced = 0,
 
   .gc = false,
   .firehose = false,
 
   .slow = false,
   .slowcpu = false,
-  .num_calls = 0,
+  .cputime = false,
+  .threads = false,
+  .calls_serial = 0,
   .threshold = 250,
 
   .num = 0,
   .num_slow = 0,
-  .list = {},
+  .num_patterns = 0,
+  .num_ruby_events = 0,
+  .num_cfunc_events = 0,
+  .num_watched = 0,
+  .list_size = 0,
+  .list = NULL,
+
+  .expr_max_len = 0,
+  .expr_max_rate = 0,
+  .expr_sample = 0,
+
+  .resolve_tbl = NULL,
+
+  .frag_buf = NULL,
+  .frag_len = 0,
+  .frag_total = 0,
+
+  .pattern_tbl = NULL,
+
+  .stack_tbl = NULL,
+  .next_stack_id = 0,
 
   .mqi_key = 0,
   .mqi_id = -1,
 
-  .mqo_fd = -1,
-  .mqo_addr = {.sun_family = AF_UNIX},
+  .ctl_pid = 0,
+  .ctl_listen_fd = -1,
+  .ctl_fd = -1,
+  .ctl_buf = NULL,
+  .ctl_len = 0,
+  .ctl_size = 0,
 
-  .sbuf = NULL,
-  .msgpacker = NULL
+  .mqo_fd = -1,
+  .mqo_addr = {.sun_family = AF_UNIX}
 };
 
 static void
   msgq_teardown(),
-  rbtracer_detach();
+  rbtrace__stacks_clear(),
+  rbtracer_detach(),
+  wakeup_setup(),
+  wakeup_signal(void *data),
+  wakeup_stop();
 
-static inline void
-rbtrace__send_event(int nargs, const char *name, ...)
+static int
+  in_receive = 0;
+
+// What the event hook touches on every call belongs to the thread running
+// it, so threads don't share a reentrancy flag, a pack buffer or a call
+// stack, even when they take turns on one native thread (M:N threads) or run
+// at the same time on different ractors. Events from all of them are merged
+// by the writer.
+typedef struct rbtrace_local {
+  int in_event_hook;
+
+  msgpack_sbuffer sbuf;
+  msgpack_packer msgpacker;
+
+  // slow watch and cputime modes, only valid while calls_serial matches rbtracer's
+  unsigned long calls_serial;
+  int num_calls;
+  int calls_size;       // grows as needed, up to MAX_CALLS
+  uint64_t *call_times;
+  uint64_t *call_cputimes;
+
+  // flight recorder, likewise
+  unsigned long recorder_serial;
+  unsigned int recorder_num_calls;
+  int recorder_size;
+  uint64_t *recorder_call_times;
+
+  // metrics, likewise
+  unsigned long metrics_serial;
+  int metrics_depth;
+  struct {
+    int stat;
+    uint64_t start;
+  } metrics_stack[METRICS_STACK];
+
+  // profile, likewise
+  unsigned long prof_serial;
+  int prof_depth;
+  int prof_size;
+  uint64_t *prof_times;
+
+  // tail, reset for every thread by tail_start/stop
+  unsigned int tail_depth;   // of the open tree, 0 if there is none
+  unsigned int tail_open;    // buffered calls yet to return
+  unsigned int tail_skip;    // depth of the subtree being left out, 0 if none
+  uint32_t tail_skipped;
+  unsigned int tail_num;
+  unsigned int tail_size;
+  struct tail_event *tail_events;
+
+  // all threads' state, for tail mode and the gc to walk
+  struct rbtrace_local *prev, *next;
+}
+rbtrace_local_t;
+
+static rbtrace_local_t *locals = NULL;
+
+#ifdef RBTRACE_WRITER_THREAD
+// threads may exit, and free their state, without holding the GVL
+static pthread_mutex_t locals_lock = PTHREAD_MUTEX_INITIALIZER;
+#define locals_lock()   pthread_mutex_lock(&locals_lock)
+#define locals_unlock() pthread_mutex_unlock(&locals_lock)
+#else
+#define locals_lock()
+#define locals_unlock()
+#endif
+
+static void
+rbtrace__local_free(void *data)
 {
-  if (!rbtracer.attached_pid ||
-      !rbtracer.sbuf ||
-      !rbtracer.msgpacker ||
-      rbtracer.mqo_fd == -1)
-    return;
+  rbtrace_local_t *local = data;
+
+  locals_lock();
+  if (local->prev)
+    local->prev->next = local->next;
+  else
+    locals = local->next;
+  if (local->next)
+    local->next->prev = local->prev;
+  locals_unlock();
+
+  msgpack_sbuffer_destroy(&local->sbuf);
+  free(local->call_times);
+  free(local->call_cputimes);
+  free(local->recorder_call_times);
+  free(local->prof_times);
+  free(local->tail_events);
+  free(local);
+}
 
-  int n;
+static rbtrace_local_t *
+rbtrace__local_new()
+{
+  rbtrace_local_t *local = calloc(1, sizeof(rbtrace_local_t));
 
-  msgpack_sbuffer_clear(rbtracer.sbuf);
-  msgpack_packer *pk = rbtracer.msgpacker;
+  if (local) {
+    msgpack_sbuffer_init(&local->sbuf);
+    msgpack_packer_init(&local->msgpacker, &local->sbuf, msgpack_sbuffer_write);
 
-  msgpack_pack_array(pk, nargs+1);
+    locals_lock();
+    if ((local->next = locals))
+      locals->prev = local;
+    locals = local;
+    locals_unlock();
+  }
 
-  msgpack_pack_bin(pk, strlen(name));
-  msgpack_pack_bin_body(pk, name, strlen(name));
+  return local;
+}
 
-  if (nargs > 0) {
-    int type;
+#if defined(HAVE_RB_INTERNAL_THREAD_SPECIFIC_GET) && defined(RBTRACE_WRITER_THREAD)
+static rb_internal_thread_specific_key_t local_key;
+static rb_internal_thread_event_hook_t *local_hook = NULL;
 
-    int sint;
-    uint32_t uint;
-    uint64_t uint64;
-    unsigned long ulong;
-    char *str;
+static void
+rbtrace__local_exited(rb_event_flag_t event, const rb_internal_thread_event_data_t *data, void *arg)
+{
+  // no GVL here, but nothing else uses an exited thread's state
+  rbtrace_local_t *local = rb_internal_thread_specific_get(data->thread, local_key);
+
+  if (local) {
+    rb_internal_thread_specific_set(data->thread, local_key, NULL);
+    rbtrace__local_free(local);
+  }
+}
 
-    va_list ap;
-    va_start(ap, name);
+// Returns NULL if the state could not be allocated. Only called on ruby
+// threads.
+static inline rbtrace_local_t *
+rbtrace_local()
+{
+  VALUE thread = rb_thread_current();
+  rbtrace_local_t *local = rb_internal_thread_specific_get(thread, local_key);
+
+  if (!local && (local = rbtrace__local_new())) {
+    rb_internal_thread_specific_set(thread, local_key, local);
+
+    // to free it again, watching for exits only once there is state to free,
+    // since any thread hook slows down every GVL handoff. The hook allocates,
+    // which it must not during GC, so the next thread adds it then.
+    if (!local_hook && !rb_during_gc())
+      local_hook = rb_internal_thread_add_event_hook(rbtrace__local_exited,
+        RUBY_INTERNAL_THREAD_EVENT_EXITED, NULL);
+  }
 
-    for (n=0; n<nargs; n++) {
-      type = va_arg(ap, int);
-      switch (type) {
-        case 'b': // boolean
-          if (va_arg(ap, int))
-            msgpack_pack_true(pk);
-          else
-            msgpack_pack_false(pk);
-          break;
+  return local;
+}
 
-        case 'd': // signed int
-          sint = va_arg(ap, int);
-          msgpack_pack_int(pk, sint);
-          break;
+static void
+rbtrace_local_setup()
+{
+  local_key = rb_internal_thread_specific_key_create();
+}
+#elif defined(RBTRACE_WRITER_THREAD)
+// the key only exists to free a thread's state when it exits
+static pthread_key_t local_key;
+static __thread rbtrace_local_t *local_current = NULL;
+
+// Returns NULL if the state could not be allocated.
+static inline rbtrace_local_t *
+rbtrace_local()
+{
+  if (!local_current && (local_current = rbtrace__local_new()))
+    pthread_setspecific(local_key, local_current);
 
-        case 'u': // unsigned int
-          uint = va_arg(ap, uint32_t);
-          msgpack_pack_uint32(pk, uint);
-          break;
+  return local_current;
+}
 
-        case 'l': // unsigned long (VALUE/ID)
-          ulong = va_arg(ap, unsigned long);
-          msgpack_pack_unsigned_long(pk, ulong);
-          break;
+static void
+rbtrace_local_setup()
+{
+  pthread_key_create(&local_key, rbtrace__local_free);
+}
+#else
+static rbtrace_local_t *local_current = NULL;
 
-        case 't': // uint64 (timestamps)
-          uint64 = va_arg(ap, uint64_t);
-          msgpack_pack_uint64(pk, uint64);
-          break;
+static inline rbtrace_local_t *
+rbtrace_local()
+{
+  if (!local_current)
+    local_current = rbtrace__local_new();
 
-        case 'n': // current timestamp
-          msgpack_pack_uint64(pk, timeofday_usec());
-          break;
+  return local_current;
+}
 
-        case 's': // string
-          str = va_arg(ap, char *);
-          if (!str)
-            str = (char *)"";
+static void
+rbtrace_local_setup()
+{
+}
+#endif
 
-          msgpack_pack_bin(pk, strlen(str));
-          msgpack_pack_bin_body(pk, str, strlen(str));
-          break;
+// Makes room for times[depth], growing the arrays together. Returns false
+// once they are as large as they get.
+static bool
+rbtrace__local_reserve(int *size, int depth, uint64_t **times, uint64_t **more)
+{
+  if (depth < *size)
+    return true;
+  if (depth >= MAX_CALLS)
+    return false;
+
+  int grown = *size ? *size * 2 : 64;
+  uint64_t *p;
+
+  while (grown <= depth)
+    grown *= 2;
+  if (grown > MAX_CALLS)
+    grown = MAX_CALLS;
+
+  if (!(p = realloc(*times, grown * sizeof(uint64_t))))
+    return false;
+  *times = p;
+
+  if (more) {
+    if (!(p = realloc(*more, grown * sizeof(uint64_t))))
+      return false;
+    *more = p;
+  }
 
-        default:
-          fprintf(stderr, "unknown type (%d) passed to rbtrace__send_event for %s\n", (int)type, name);
-      }
+  *size = grown;
+  return true;
+}
+
+// Pushes the times a call started at onto the thread's stack, or pops them
+// when it returns and sets how long it took. Both stay 0 for calls made
+// deeper than the stack goes, or before it was reset.
+static void
+rbtrace__local_time(rbtrace_local_t *local, bool call, uint64_t usec, uint64_t cpu_usec, uint64_t *wall, uint64_t *cpu)
+{
+  if (local->calls_serial != rbtracer.calls_serial) {
+    local->calls_serial = rbtracer.calls_serial;
+    local->num_calls = 0;
+  }
+
+  if (call) {
+    if (rbtrace__local_reserve(&local->calls_size, local->num_calls, &local->call_times, &local->call_cputimes)) {
+      local->call_times[ local->num_calls ] = usec;
+      local->call_cputimes[ local->num_calls ] = cpu_usec;
     }
+    local->num_calls++;
 
-    va_end(ap);
+  } else if (local->num_calls > 0) {
+    local->num_calls--;
+
+    if (local->num_calls < local->calls_size) {
+      *wall = usec - local->call_times[ local->num_calls ];
+      *cpu = cpu_usec - local->call_cputimes[ local->num_calls ];
+    }
   }
+}
+
+// Returns -1 with errno set if the event could not be sent.
+static int
+rbtrace__sendto(const char *data, size_t size)
+{
+  int ret = -1, n;
 
-  int ret = -1;
   for (n=0; n<10 && ret==-1; n++)
     ret = sendto(
-      rbtracer.mqo_fd,
-      rbtracer.sbuf->data, rbtracer.sbuf->size,
+      __atomic_load_n(&rbtracer.mqo_fd, __ATOMIC_RELAXED),
+      data, size,
 #ifdef MSG_NOSIGNAL
       MSG_NOSIGNAL,
 #else
@@ -267,287 +572,4115 @@ rbtrace__send_event(int nargs, const char *name, ...)
       (const struct sockaddr *)&rbtracer.mqo_addr, rbtracer.mqo_len
     );
 
-  if (ret == -1 && (errno == EINVAL || errno == ENOENT || errno == ECONNREFUSED || errno == EPIPE)) {
-    fprintf(stderr, "sendto(%d): %s [detaching]\n", rbtracer.mqo_fd, strerror(errno));
+  return ret;
+}
+
+static void
+rbtrace__send_failed(int err)
+{
+  if (!rbtracer.attached_pid) {
+    // nobody is listening for the handshake, which is fine
+  } else if (err == EINVAL || err == ENOENT || err == ECONNREFUSED || err == EPIPE) {
+    fprintf(stderr, "sendto(%d): %s [detaching]\n", rbtracer.mqo_fd, strerror(err));
 
     msgq_teardown();
     rbtracer_detach();
-  } else if (ret == -1) {
-    fprintf(stderr, "sendto(%d): %s\n", rbtracer.mqo_fd, strerror(errno));
+  } else {
+    fprintf(stderr, "sendto(%d): %s\n", rbtracer.mqo_fd, strerror(err));
   }
 }
 
+#ifdef RBTRACE_WRITER_THREAD
+// Events are not sent from the ruby thread that produced them, where a full
+// socket would stall the application while holding the GVL. They are copied
+// into a ring buffer instead, and a native writer thread does the sending.
+//
+// Producers may be hooks running in parallel on different ractors, so they
+// take a lock to append, while the writer consumes without one. When the ring
+// fills up, events are dropped and counted rather than waited on.
+#define WRITER_RING_SIZE (1 << 20)
+
+static struct {
+  pid_t pid;            // the writer does not survive a fork
+  int fds[2];           // pipe used to wake a sleeping writer
+  char *ring;
+  pthread_mutex_t lock; // held by producers while appending
+  uint64_t head;        // advanced by ruby threads
+  uint64_t tail;        // advanced by the writer, once an event is sent
+  int sleeping;
+  int error;            // errno of a failed send, handled on a ruby thread
+  uint32_t dropped;
+} writer = {
+  .pid = 0,
+  .fds = {-1, -1},
+  .ring = NULL,
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+  .head = 0,
+  .tail = 0,
+  .sleeping = 0,
+  .error = 0,
+  .dropped = 0
+};
+
 static inline void
-rbtrace__send_names(ID mid, VALUE klass)
+writer__copy_in(uint64_t pos, const void *src, size_t len)
 {
-  if (!rbtracer.mid_tbl)
-    rbtracer.mid_tbl = st_init_numtable();
+  size_t off = pos & (WRITER_RING_SIZE - 1);
+  size_t first = len < WRITER_RING_SIZE - off ? len : WRITER_RING_SIZE - off;
 
-  if (!st_is_member(rbtracer.mid_tbl, mid)) {
-    st_insert(rbtracer.mid_tbl, (st_data_t)mid, (st_data_t)1);
-    rbtrace__send_event(2,
-      "mid",
-      'l', mid,
-      's', rb_id2name(mid)
-    );
-  }
+  memcpy(writer.ring + off, src, first);
+  memcpy(writer.ring, (const char *)src + first, len - first);
+}
 
-  if (!rbtracer.klass_tbl)
-    rbtracer.klass_tbl = st_init_numtable();
+static inline void
+writer__copy_out(uint64_t pos, void *dst, size_t len)
+{
+  size_t off = pos & (WRITER_RING_SIZE - 1);
+  size_t first = len < WRITER_RING_SIZE - off ? len : WRITER_RING_SIZE - off;
 
-  if (rbtracer.devmode || !st_is_member(rbtracer.klass_tbl, klass)) {
-    if (!rbtracer.devmode)
-      st_insert(rbtracer.klass_tbl, (st_data_t)klass, (st_data_t)1);
+  memcpy(dst, writer.ring + off, first);
+  memcpy((char *)dst + first, writer.ring, len - first);
+}
 
-    rbtrace__send_event(2,
-      "klass",
-      'l', klass,
-      's', rb_class2name(klass)
-    );
-  }
+// The caller holds the lock and checks there is room.
+static inline void
+writer__append(const char *data, uint32_t len)
+{
+  uint64_t head = writer.head;
+
+  writer__copy_in(head, &len, 4);
+  writer__copy_in(head + 4, data, len);
+  __atomic_store_n(&writer.head, head + 4 + len, __ATOMIC_SEQ_CST);
+}
+
+// Returns how many bytes of events could be queued right now.
+static inline size_t
+writer_room()
+{
+  if (writer.pid != getpid())
+    return SIZE_MAX;
+
+  return WRITER_RING_SIZE - (__atomic_load_n(&writer.head, __ATOMIC_ACQUIRE) -
+                             __atomic_load_n(&writer.tail, __ATOMIC_ACQUIRE));
 }
 
-static int in_event_hook = 0;
+typedef struct {
+  size_t len;
+  int cancel;
+} writer_wait_t;
+
+static void *
+writer__wait(void *data)
+{
+  writer_wait_t *wait = data;
+  int n;
+
+  for (n=0; n<1000 && !__atomic_load_n(&wait->cancel, __ATOMIC_ACQUIRE) && writer_room() < wait->len; n++)
+    usleep(1000);
+
+  return NULL;
+}
 
 static void
-#ifdef RUBY_VM
-event_hook(rb_event_flag_t event, VALUE data, VALUE self, ID mid, VALUE klass)
+writer__wait_cancel(void *data)
+{
+  __atomic_store_n(&((writer_wait_t *)data)->cancel, 1, __ATOMIC_RELEASE);
+}
+
+// Waits up to a second for room to queue len bytes of events. writer_push
+// waits itself for replies to commands, but callers reading state other
+// threads change should wait before reading it. The GVL is released meanwhile, so the application keeps
+// running, but interrupts are left for later, so callers need not expect
+// an exception.
+static void
+writer_wait(size_t len)
+{
+  writer_wait_t wait = {
+    .len = len + 64, // and a drop report
+    .cancel = 0
+  };
+
+  if (writer_room() >= wait.len)
+    return;
+
+#if defined(HAVE_RB_NOGVL)
+  rb_nogvl(writer__wait, &wait, writer__wait_cancel, &wait, RB_NOGVL_INTR_FAIL);
 #else
-event_hook(rb_event_t event, NODE *node, VALUE self, ID mid, VALUE klass)
+  writer__wait(&wait);
 #endif
+}
+
+// Returns false if there is no writer, and the event should be sent directly.
+static bool
+writer_push(const char *data, size_t len)
 {
-  // do not re-enter this function
-  // after this, must `goto out` instead of `return`
-  if (in_event_hook) return;
-  in_event_hook++;
+  if (writer.pid != getpid())
+    return false;
 
-#ifdef ID_ALLOCATOR
-  // skip allocators
-  if (mid == ID_ALLOCATOR) goto out;
+  rbtrace_local_t *local = rbtrace_local();
+  // replies to commands are worth waiting for, traced calls are not. The GVL
+  // is released while waiting, so it must not be during GC either.
+  bool wait = local && !local->in_event_hook && in_receive;
+  int n;
+
+#ifdef HAVE_RB_DURING_GC
+  if (wait && rb_during_gc())
+    wait = false;
 #endif
 
-#ifdef RUBY_VM
-  if (mid == 0) {
-    ID _mid;
-    VALUE _klass;
-    rb_frame_method_id_and_class(&_mid, &_klass);
+  pthread_mutex_lock(&writer.lock);
 
-    mid = _mid;
-    klass = _klass;
+  for (n=0; 4 + len + (writer.dropped ? 64 : 0) > // room to report drops in
+            WRITER_RING_SIZE - (writer.head - __atomic_load_n(&writer.tail, __ATOMIC_ACQUIRE)); n++) {
+    if (n > 0 || !wait) {
+      writer.dropped++;
+      pthread_mutex_unlock(&writer.lock);
+      return true;
+    }
+    pthread_mutex_unlock(&writer.lock);
+    writer_wait(4 + len);
+    pthread_mutex_lock(&writer.lock);
   }
-#endif
 
-  // normalize klass and check for class-level methods
-  bool singleton = false;
-  if (klass) {
-    if (TYPE(klass) == T_ICLASS) {
-      klass = RBASIC_CLASS(klass);
-    }
+  if (writer.dropped) {
+    // let the client know what it missed
+    msgpack_sbuffer buf;
+    msgpack_packer pk;
+
+    msgpack_sbuffer_init(&buf);
+    msgpack_packer_init(&pk, &buf, msgpack_sbuffer_write);
+    msgpack_pack_array(&pk, 2);
+    msgpack_pack_bin(&pk, 7);
+    msgpack_pack_bin_body(&pk, "dropped", 7);
+    msgpack_pack_uint32(&pk, writer.dropped);
+
+    writer__append(buf.data, buf.size);
+    writer.dropped = 0;
+    msgpack_sbuffer_destroy(&buf);
+
+    // names and stacks may have been dropped as well, so send them again
+    if (rbtracer.mid_tbl)
+      st_clear(rbtracer.mid_tbl);
+    if (rbtracer.klass_tbl)
+      st_clear(rbtracer.klass_tbl);
+    rbtrace__stacks_clear();
+  }
 
-    singleton = FL_TEST(klass, FL_SINGLETON);
+  writer__append(data, len);
+  pthread_mutex_unlock(&writer.lock);
 
-#ifdef RUBY_VM
-    if (singleton &&
-        !(TYPE(self) == T_CLASS ||
-          TYPE(self) == T_MODULE))
-      singleton = false;
-#endif
+  if (__atomic_load_n(&writer.sleeping, __ATOMIC_SEQ_CST) &&
+      write(writer.fds[1], "", 1) == -1) {
+    // pipe is full, so a wakeup is pending already
   }
 
-  rbtracer_t *tracer = NULL;
+  return true;
+}
 
-  if (rbtracer.firehose) {
-    // trace everything
+// Called on ruby threads, to act on any errors the writer ran into.
+static inline void
+writer_check()
+{
+  int err;
 
-  } else if (rbtracer.num > 0) {
-    // tracing only specific methods
-    unsigned int i, n;
-    for (i=0, n=0; i<MAX_TRACERS && n<rbtracer.num; i++) {
-      rbtracer_t *curr = &rbtracer.list[i];
+  if (writer.pid == getpid() &&
+      (err = __atomic_exchange_n(&writer.error, 0, __ATOMIC_ACQ_REL)))
+    rbtrace__send_failed(err);
+}
 
-      if (curr->query) {
-        n++;
+// Waits briefly for queued events to be sent. Returns false if the writer is
+// still busy, and might be using the socket.
+static bool
+writer_flush()
+{
+  int n;
 
-        // there should never be slow method tracers outside slow mode
-        if (!rbtracer.slow && curr->is_slow) continue;
+  if (writer.pid != getpid())
+    return true;
 
-        if (rbtracer.devmode) {
-          if ((!curr->mid        || curr->mid == mid) &&
-              (!curr->klass_name || (
-                (singleton == curr->is_singleton) &&
-                (0 == strncmp(rb_class2name(singleton ? self : klass), curr->klass_name, curr->klass_len)))))
-          {
-            tracer = curr;
-            break;
-          }
-        } else {
-          if ((!curr->mid   || curr->mid == mid) &&
-              (!curr->klass || curr->klass == klass) &&
-              (!curr->self  || curr->self == self))
-          {
-            tracer = curr;
-            break;
-          }
-        }
+  for (n=0; n<100; n++) {
+    if (__atomic_load_n(&writer.tail, __ATOMIC_ACQUIRE) == __atomic_load_n(&writer.head, __ATOMIC_ACQUIRE))
+      return true;
+    usleep(1000);
+  }
+
+  return false;
+}
+
+static void *
+writer_thread(void *data)
+{
+  char *buf = malloc(WRITER_RING_SIZE);
+  char discard[64];
+  uint32_t len;
+
+  while (buf) {
+    uint64_t tail = writer.tail;
+
+    if (tail == __atomic_load_n(&writer.head, __ATOMIC_ACQUIRE)) {
+      // check again after announcing we are asleep, so a producer either
+      // sees the flag or we see its event
+      __atomic_store_n(&writer.sleeping, 1, __ATOMIC_SEQ_CST);
+
+      if (tail == __atomic_load_n(&writer.head, __ATOMIC_SEQ_CST)) {
+        struct pollfd pfd = {.fd = writer.fds[0], .events = POLLIN};
+        poll(&pfd, 1, -1);
+        while (read(writer.fds[0], discard, sizeof(discard)) == sizeof(discard));
       }
+
+      __atomic_store_n(&writer.sleeping, 0, __ATOMIC_SEQ_CST);
+      continue;
     }
 
-    if (tracer) {
-      // matched something, all good!
-    } else if (rbtracer.slow && rbtracer.num_slow == 0) {
-      // in global slow mode, so go ahead.
-    } else {
-      goto out;
+    writer__copy_out(tail, &len, 4);
+    writer__copy_out(tail + 4, buf, len);
+
+    if (rbtrace__sendto(buf, len) == -1) {
+      int expected = 0;
+      __atomic_compare_exchange_n(&writer.error, &expected, errno, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
     }
 
-  } else if (rbtracer.slow && rbtracer.num_slow == 0) {
-    // trace everything that's slow
+    __atomic_store_n(&writer.tail, tail + 4 + len, __ATOMIC_RELEASE);
+  }
 
-  } else {
+  return NULL;
+}
+
+static void
+writer_setup()
+{
+  pid_t pid = getpid();
+  pthread_t thread;
+  sigset_t all, old;
+
+  if (writer.pid == pid)
+    return;
+
+  // anything queued before a fork belongs to the parent, and so might the lock
+  pthread_mutex_init(&writer.lock, NULL);
+  writer.pid = 0;
+  writer.head = writer.tail = 0;
+  writer.sleeping = writer.error = 0;
+  writer.dropped = 0;
+
+  if (writer.fds[0] != -1) {
+    close(writer.fds[0]);
+    close(writer.fds[1]);
+    writer.fds[0] = writer.fds[1] = -1;
+  }
+
+  if (!writer.ring && !(writer.ring = malloc(WRITER_RING_SIZE)))
+    return;
+
+  if (pipe(writer.fds) == -1) {
+    writer.fds[0] = writer.fds[1] = -1;
+    return;
+  }
+
+  fcntl(writer.fds[0], F_SETFL, fcntl(writer.fds[0], F_GETFL) | O_NONBLOCK);
+  fcntl(writer.fds[1], F_SETFL, fcntl(writer.fds[1], F_GETFL) | O_NONBLOCK);
+  fcntl(writer.fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(writer.fds[1], F_SETFD, FD_CLOEXEC);
+
+  // signals are for ruby threads to handle
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+
+  if (pthread_create(&thread, NULL, writer_thread, NULL) == 0) {
+    pthread_detach(thread);
+    writer.pid = pid;
+  }
+
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+}
+#else
+static bool
+writer_push(const char *data, size_t len)
+{
+  return false;
+}
+
+static inline size_t
+writer_room()
+{
+  return SIZE_MAX;
+}
+
+static void
+writer_wait(size_t len)
+{
+}
+
+static inline void
+writer_check()
+{
+}
+
+static bool
+writer_flush()
+{
+  return true;
+}
+
+static void
+writer_setup()
+{
+}
+#endif
+
+static inline void
+rbtrace__vsend_event(int nargs, const char *name, va_list ap)
+{
+  rbtrace_local_t *local = rbtrace_local();
+
+  if (!local || rbtracer.mqo_fd == -1)
+    return;
+
+  writer_check();
+  if (rbtracer.mqo_fd == -1)
+    return;
+
+  int n;
+
+  msgpack_sbuffer_clear(&local->sbuf);
+  msgpack_packer *pk = &local->msgpacker;
+
+  msgpack_pack_array(pk, nargs+1);
+
+  msgpack_pack_bin(pk, strlen(name));
+  msgpack_pack_bin_body(pk, name, strlen(name));
+
+  if (nargs > 0) {
+    int type;
+
+    int sint;
+    uint32_t uint;
+    uint64_t uint64;
+    unsigned long ulong;
+    char *str;
+
+    for (n=0; n<nargs; n++) {
+      type = va_arg(ap, int);
+      switch (type) {
+        case 'b': // boolean
+          if (va_arg(ap, int))
+            msgpack_pack_true(pk);
+          else
+            msgpack_pack_false(pk);
+          break;
+
+        case 'd': // signed int
+          sint = va_arg(ap, int);
+          msgpack_pack_int(pk, sint);
+          break;
+
+        case 'u': // unsigned int
+          uint = va_arg(ap, uint32_t);
+          msgpack_pack_uint32(pk, uint);
+          break;
+
+        case 'l': // unsigned long (VALUE/ID)
+          ulong = va_arg(ap, unsigned long);
+          msgpack_pack_unsigned_long(pk, ulong);
+          break;
+
+        case 't': // uint64 (timestamps)
+          uint64 = va_arg(ap, uint64_t);
+          msgpack_pack_uint64(pk, uint64);
+          break;
+
+        case 'n': // current timestamp
+          msgpack_pack_uint64(pk, timeofday_usec());
+          break;
+
+        case 'a': // array of int64 (count, pointer)
+          sint = va_arg(ap, int);
+          int64_t *vals = va_arg(ap, int64_t *);
+
+          msgpack_pack_array(pk, sint);
+          while (sint-- > 0)
+            msgpack_pack_int64(pk, *vals++);
+          break;
+
+        case 's': // string
+          str = va_arg(ap, char *);
+          if (!str)
+            str = (char *)"";
+
+          msgpack_pack_bin(pk, strlen(str));
+          msgpack_pack_bin_body(pk, str, strlen(str));
+          break;
+
+        case 'S': // bytes (length, pointer)
+          sint = va_arg(ap, int);
+          str = va_arg(ap, char *);
+
+          msgpack_pack_bin(pk, sint);
+          msgpack_pack_bin_body(pk, str, sint);
+          break;
+
+        default:
+          fprintf(stderr, "unknown type (%d) passed to rbtrace__send_event for %s\n", (int)type, name);
+      }
+    }
+  }
+
+  if (writer_push(local->sbuf.data, local->sbuf.size))
+    return;
+
+  if (rbtrace__sendto(local->sbuf.data, local->sbuf.size) == -1)
+    rbtrace__send_failed(errno);
+}
+
+static void
+rbtrace__send_event(int nargs, const char *name, ...)
+{
+  if (!rbtracer.attached_pid)
+    return;
+
+  va_list ap;
+  va_start(ap, name);
+  rbtrace__vsend_event(nargs, name, ap);
+  va_end(ap);
+}
+
+// Like rbtrace__send_event, but also before a client has attached. Used to
+// tell a client waiting on its socket that we are ready for commands.
+static void
+rbtrace__send_handshake(int nargs, const char *name, ...)
+{
+  va_list ap;
+  va_start(ap, name);
+  rbtrace__vsend_event(nargs, name, ap);
+  va_end(ap);
+}
+
+static inline void
+rbtrace__send_names(ID mid, VALUE klass)
+{
+  if (!rbtracer.mid_tbl)
+    rbtracer.mid_tbl = st_init_numtable();
+
+  if (!st_is_member(rbtracer.mid_tbl, mid)) {
+    st_insert(rbtracer.mid_tbl, (st_data_t)mid, (st_data_t)1);
+    rbtrace__send_event(2,
+      "mid",
+      'l', mid,
+      's', rb_id2name(mid)
+    );
+  }
+
+  if (!rbtracer.klass_tbl)
+    rbtracer.klass_tbl = st_init_numtable();
+
+  if (!st_is_member(rbtracer.klass_tbl, klass)) {
+    const char *name = rb_class2name(klass);
+
+    // anonymous classes may be named later on (Foo = Class.new), so keep
+    // resending their names in devmode until they are
+    if (!rbtracer.devmode || (name && name[0] != '#'))
+      st_insert(rbtracer.klass_tbl, (st_data_t)klass, (st_data_t)1);
+
+    rbtrace__send_event(2,
+      "klass",
+      'l', klass,
+      's', name
+    );
+  }
+}
+
+// The flight recorder keeps the most recent slow calls (and optionally GCs) in
+// a fixed size ring, whether or not a client is attached. Nothing is written
+// anywhere until the ring is dumped, either to a client or from ruby.
+#define RECORDER_SIZE 4096
+
+typedef struct {
+  char type; // 's'low, 'c'slow or 'g'c
+  bool singleton;
+  uint32_t depth;
+  uint64_t start;
+  uint64_t duration;
+  ID mid;
+  VALUE klass;
+} recorder_entry_t;
+
+static struct {
+  bool enabled;
+  bool gc;
+  uint64_t threshold; // usec
+  uint64_t window;    // usec, older entries are left out of dumps
+
+  uint64_t count;     // entries ever recorded, the ring holds the last few
+  recorder_entry_t *ring;
+
+  recorder_entry_t *dump; // copy of the window being sent
+  uint32_t num_dump;
+
+  unsigned long calls_serial; // bumped to reset every thread's call stack
+}
+recorder = {
+  .enabled = false,
+  .gc = false,
+  .threshold = 0,
+  .window = 0,
+  .count = 0,
+  .ring = NULL,
+  .dump = NULL,
+  .num_dump = 0,
+  .calls_serial = 0
+};
+
+static void
+recorder_add(char type, uint64_t start, uint64_t duration, uint32_t depth, ID mid, VALUE klass, bool singleton)
+{
+  recorder_entry_t *entry = &recorder.ring[ recorder.count++ % RECORDER_SIZE ];
+
+  entry->type = type;
+  entry->start = start;
+  entry->duration = duration;
+  entry->depth = depth;
+  entry->mid = mid;
+  entry->klass = klass;
+  entry->singleton = singleton;
+}
+
+static inline void
+recorder_hook(rbtrace_local_t *local, bool call, bool cfunc, ID mid, VALUE klass, bool singleton)
+{
+  uint64_t usec = timeofday_usec();
+
+  if (local->recorder_serial != recorder.calls_serial) {
+    local->recorder_serial = recorder.calls_serial;
+    local->recorder_num_calls = 0;
+  }
+
+  if (call) {
+    if (rbtrace__local_reserve(&local->recorder_size, local->recorder_num_calls, &local->recorder_call_times, NULL))
+      local->recorder_call_times[ local->recorder_num_calls ] = usec;
+    local->recorder_num_calls++;
+
+  } else if (local->recorder_num_calls > 0) {
+    local->recorder_num_calls--;
+
+    if (local->recorder_num_calls < (unsigned int)local->recorder_size) {
+      uint64_t start = local->recorder_call_times[ local->recorder_num_calls ];
+
+      if (usec - start > recorder.threshold)
+        recorder_add(cfunc ? 'c' : 's', start, usec - start, local->recorder_num_calls, mid, klass, singleton);
+    }
+  }
+}
+
+// Calls fn on every entry still inside the window, oldest first.
+static void
+recorder_each(void (*fn)(recorder_entry_t *, void *), void *arg)
+{
+  uint64_t i = recorder.count > RECORDER_SIZE ? recorder.count - RECORDER_SIZE : 0;
+  uint64_t since = timeofday_usec() - recorder.window;
+
+  for (; i < recorder.count; i++) {
+    recorder_entry_t *entry = &recorder.ring[ i % RECORDER_SIZE ];
+    if (entry->start + entry->duration >= since)
+      fn(entry, arg);
+  }
+}
+
+static void
+recorder__copy(recorder_entry_t *entry, void *arg)
+{
+  recorder.dump[ recorder.num_dump++ ] = *entry;
+}
+
+static void
+recorder__send(recorder_entry_t *entry)
+{
+  // room for the event and its names
+  writer_wait(1024);
+
+  if (entry->type == 'g') {
+    rbtrace__send_event(1,
+      "gc",
+      't', entry->start
+    );
+    return;
+  }
+
+  rbtrace__send_names(entry->mid, entry->klass);
+  rbtrace__send_event(6,
+    entry->type == 's' ? "slow" : "cslow",
+    't', entry->start,
+    't', entry->duration,
+    'u', entry->depth,
+    'l', entry->mid,
+    'b', entry->singleton,
+    'l', entry->klass
+  );
+}
+
+// Sends everything recorded to the attached client, as slow mode would have.
+// The window is copied out first, since waiting on the writer lets other
+// threads record calls meanwhile.
+static void
+recorder_send()
+{
+  uint32_t i, num = 0;
+
+  if (recorder.dump)
+    return;
+
+  if (recorder.ring && (recorder.dump = malloc(RECORDER_SIZE * sizeof(recorder_entry_t)))) {
+    recorder.num_dump = 0;
+    recorder_each(recorder__copy, NULL);
+
+    for (i=0; i<recorder.num_dump; i++)
+      recorder__send(&recorder.dump[i]);
+    num = recorder.num_dump;
+
+    free(recorder.dump);
+    recorder.dump = NULL;
+    recorder.num_dump = 0;
+  }
+
+  writer_wait(64);
+  rbtrace__send_event(1,
+    "recorded",
+    'u', num
+  );
+}
+
+static void
+  event_hook_update();
+
+static void
+recorder_start(uint32_t msec, uint32_t seconds, bool gc)
+{
+  if (!recorder.ring &&
+      !(recorder.ring = calloc(RECORDER_SIZE, sizeof(recorder_entry_t))))
+    return;
+
+  if (!recorder.enabled)
+    recorder.calls_serial++;
+
+  recorder.threshold = (uint64_t)msec * 1000;
+  recorder.window = (uint64_t)seconds * 1000000;
+  recorder.gc = gc;
+  recorder.enabled = true;
+
+  event_hook_update();
+}
+
+static void
+recorder_stop()
+{
+  recorder.enabled = false;
+  recorder.gc = false;
+  recorder.count = 0;
+
+  free(recorder.ring);
+  recorder.ring = NULL;
+
+  event_hook_update();
+}
+
+// Stacks of slow calls are sent once, and referred to by id after that.
+typedef struct {
+  int num;
+  VALUE *frames;
+  int *lines;
+} rbtrace_stack_t;
+
+static int
+rbtrace__stack_cmp(st_data_t a, st_data_t b)
+{
+  rbtrace_stack_t *x = (rbtrace_stack_t *)a, *y = (rbtrace_stack_t *)b;
+
+  return x->num != y->num ||
+         memcmp(x->frames, y->frames, x->num * sizeof(VALUE)) ||
+         memcmp(x->lines, y->lines, x->num * sizeof(int));
+}
+
+static st_index_t
+rbtrace__stack_hash(st_data_t a)
+{
+  rbtrace_stack_t *x = (rbtrace_stack_t *)a;
+  st_index_t h = x->num;
+  int i;
+
+  for (i=0; i<x->num; i++)
+    h = (h * 31 + (st_index_t)x->frames[i]) * 31 + x->lines[i];
+
+  return h;
+}
+
+static const struct st_hash_type rbtrace_stack_type = {
+  rbtrace__stack_cmp,
+  rbtrace__stack_hash
+};
+
+static int
+rbtrace__free_key(st_data_t key, st_data_t val, st_data_t arg)
+{
+  free((void *)key);
+  return ST_CONTINUE;
+}
+
+static void
+rbtrace__stacks_clear()
+{
+  if (rbtracer.stack_tbl) {
+    st_foreach(rbtracer.stack_tbl, rbtrace__free_key, 0);
+    st_clear(rbtracer.stack_tbl);
+  }
+}
+
+// Returns the id of the current stack, sending it first if it is new, or -1
+// if stacks cannot be captured.
+static int
+rbtrace__send_stack()
+{
+#ifdef HAVE_RB_PROFILE_FRAMES
+  VALUE frames[MAX_STACK_FRAMES];
+  int lines[MAX_STACK_FRAMES];
+  rbtrace_stack_t stack = {0, frames, lines};
+  st_data_t id;
+  int i;
+
+  stack.num = rb_profile_frames(0, MAX_STACK_FRAMES, frames, lines);
+  if (stack.num <= 0)
+    return -1;
+
+  if (!rbtracer.stack_tbl)
+    rbtracer.stack_tbl = st_init_table(&rbtrace_stack_type);
+
+  if (st_lookup(rbtracer.stack_tbl, (st_data_t)&stack, &id))
+    return (int)id;
+
+  // ids keep counting up, so the client can cache them across a reset
+  if (rbtracer.stack_tbl->num_entries >= MAX_STACKS)
+    rbtrace__stacks_clear();
+
+  rbtrace_stack_t *copy = malloc(sizeof(rbtrace_stack_t) + stack.num * (sizeof(VALUE) + sizeof(int)));
+  if (!copy)
+    return -1;
+
+  copy->num = stack.num;
+  copy->frames = (VALUE *)(copy + 1);
+  copy->lines = (int *)(copy->frames + stack.num);
+  memcpy(copy->frames, frames, stack.num * sizeof(VALUE));
+  memcpy(copy->lines, lines, stack.num * sizeof(int));
+
+  id = rbtracer.next_stack_id++;
+  st_insert(rbtracer.stack_tbl, (st_data_t)copy, id);
+
+  VALUE str = rb_str_buf_new(0);
+  for (i=0; i<stack.num; i++) {
+    VALUE path = rb_profile_frame_path(frames[i]);
+    VALUE label = rb_profile_frame_full_label(frames[i]);
+
+    if (i > 0)
+      rb_str_cat_cstr(str, "\n");
+
+    if (NIL_P(path))
+      rb_str_catf(str, "%"PRIsVALUE, label);
+    else
+      rb_str_catf(str, "%"PRIsVALUE":%d:in `%"PRIsVALUE"'", path, lines[i], label);
+  }
+
+  rbtrace__send_event(2,
+    "stack",
+    'd', (int)id,
+    's', StringValueCStr(str)
+  );
+
+  return (int)id;
+#else
+  return -1;
+#endif
+}
+
+// the backtrace being sent, whose frames must stay alive while writer_push
+// waits for room without the GVL
+static struct {
+  VALUE *frames;
+  int num;
+  st_table *frame_tbl;
+}
+backtrace = {
+  .frames = NULL,
+  .num = 0,
+  .frame_tbl = NULL,
+};
+
+// Sends the backtraces of all threads, up to limit frames each (or all of them
+// if negative). Each distinct frame is sent once as a "btframe" with its path
+// and label, and threads as a "btthread" followed by "btframes" chunks of
+// frame ids and line numbers, so no single event grows with the thread count
+// or stack depth. "btdone" has the number of threads, or -1 if backtraces
+// cannot be walked natively and the client should eval instead.
+static void
+rbtrace_backtraces(int limit)
+{
+#ifdef HAVE_RB_PROFILE_THREAD_FRAMES
+  int size = 1024;
+  VALUE *frames = malloc(size * sizeof(VALUE));
+  int *lines = malloc(size * sizeof(int));
+  int64_t ids[BACKTRACE_CHUNK], nums[BACKTRACE_CHUNK];
+  st_table *frame_tbl = backtrace.frame_tbl = st_init_numtable();
+  st_data_t id;
+  int num_threads = 0;
+  long t;
+
+  if (limit < 0 || limit > MAX_BACKTRACE)
+    limit = MAX_BACKTRACE;
+
+  VALUE threads = rb_funcall(rb_cThread, rb_intern("list"), 0);
+
+  for (t=0; frames && lines && t<RARRAY_LEN(threads); t++) {
+    VALUE thread = rb_ary_entry(threads, t);
+    VALUE name = rb_funcall(thread, rb_intern("name"), 0);
+
+    if (!NIL_P(name) && 0 == strcmp(StringValueCStr(name), "__RBTrace__"))
+      continue;
+
+    VALUE desc = rb_inspect(thread);
+    rbtrace__send_event(2,
+      "btthread",
+      'u', num_threads,
+      's', StringValueCStr(desc)
+    );
+
+    // walking from an offset skips frames incorrectly on some rubies, so
+    // grab the whole stack at once and grow the buffer until it fits
+    int n = 0, i, j;
+    while (true) {
+      n = rb_profile_thread_frames(thread, 0, size < limit ? size : limit, frames, lines);
+      if (n < size || size >= limit)
+        break;
+
+      VALUE *more_frames = realloc(frames, size * 2 * sizeof(VALUE));
+      if (more_frames)
+        frames = more_frames;
+      int *more_lines = realloc(lines, size * 2 * sizeof(int));
+      if (more_lines)
+        lines = more_lines;
+      if (!more_frames || !more_lines)
+        break;
+
+      size *= 2;
+    }
+    backtrace.frames = frames;
+    backtrace.num = n;
+
+    for (i=0; i<n; i+=BACKTRACE_CHUNK) {
+      int chunk = n - i < BACKTRACE_CHUNK ? n - i : BACKTRACE_CHUNK;
+
+      for (j=0; j<chunk; j++) {
+        VALUE frame = frames[i+j];
+
+        if (!st_lookup(frame_tbl, (st_data_t)frame, &id)) {
+          id = frame_tbl->num_entries;
+          st_insert(frame_tbl, (st_data_t)frame, id);
+
+          VALUE path = rb_profile_frame_path(frame);
+          VALUE label = rb_profile_frame_full_label(frame);
+
+          rbtrace__send_event(3,
+            "btframe",
+            'u', (uint32_t)id,
+            's', NIL_P(path) ? NULL : StringValueCStr(path),
+            's', NIL_P(label) ? NULL : StringValueCStr(label)
+          );
+        }
+
+        ids[j] = id;
+        nums[j] = lines[i+j];
+      }
+
+      rbtrace__send_event(3,
+        "btframes",
+        'u', num_threads,
+        'a', chunk, ids,
+        'a', chunk, nums
+      );
+    }
+
+    num_threads++;
+    backtrace.num = 0;
+  }
+
+  backtrace.frame_tbl = NULL;
+  st_free_table(frame_tbl);
+  free(frames);
+  free(lines);
+
+  rbtrace__send_event(1,
+    "btdone",
+    'd', num_threads
+  );
+#else
+  rbtrace__send_event(1,
+    "btdone",
+    'd', -1
+  );
+#endif
+}
+
+static int
+rbtracer__free_mids(st_data_t key, st_data_t val, st_data_t arg)
+{
+  st_free_table((st_table *)val);
+  return ST_CONTINUE;
+}
+
+static void
+rbtracer_patterns_clear()
+{
+  if (rbtracer.pattern_tbl) {
+    st_foreach(rbtracer.pattern_tbl, rbtracer__free_mids, 0);
+    st_clear(rbtracer.pattern_tbl);
+  }
+}
+
+static bool
+rbtracer_pattern_match(rbtracer_pattern_t *pat, const char *name)
+{
+  if (!pat->pattern)
+    return true;
+  if (!name)
+    return false;
+
+  if (pat->is_regex)
+    return 0 == regexec(&pat->regex, name, 0, NULL, 0);
+  else
+    return 0 == fnmatch(pat->pattern, name, FNM_NOESCAPE);
+}
+
+static rbtracer_t *
+rbtracer_pattern_lookup(VALUE klass, bool singleton, ID mid)
+{
+  st_data_t key = (st_data_t)klass | singleton; // classes are at least word aligned
+  st_data_t mids, id;
+  unsigned int i, n;
+
+  if (!rbtracer.pattern_tbl)
+    rbtracer.pattern_tbl = st_init_numtable();
+
+  if (!st_lookup(rbtracer.pattern_tbl, key, &mids)) {
+    if (rbtracer.pattern_tbl->num_entries >= MAX_KLASS_CACHE)
+      rbtracer_patterns_clear();
+
+    mids = (st_data_t)st_init_numtable();
+    st_insert(rbtracer.pattern_tbl, key, mids);
+  }
+
+  if (!st_lookup((st_table *)mids, (st_data_t)mid, &id)) {
+    const char *klass_name = klass ? rb_class2name(klass) : NULL;
+    const char *mid_name = mid ? rb_id2name(mid) : NULL;
+
+    id = 0;
+    for (i=0, n=0; i<rbtracer.list_size && n<rbtracer.num; i++) {
+      rbtracer_t *curr = &rbtracer.list[i];
+      if (!curr->query) continue;
+      n++;
+
+      if (!curr->is_pattern) continue;
+      if (!rbtracer.slow && curr->is_slow) continue;
+
+      if ((!curr->mid || curr->mid == mid) &&
+          (!curr->klass_pattern.pattern || singleton == curr->is_singleton) &&
+          rbtracer_pattern_match(&curr->klass_pattern, klass_name) &&
+          rbtracer_pattern_match(&curr->mid_pattern, mid_name))
+      {
+        id = curr->id + 1;
+        break;
+      }
+    }
+
+    st_insert((st_table *)mids, (st_data_t)mid, id);
+  }
+
+  return id ? &rbtracer.list[id-1] : NULL;
+}
+
+static void
+rbtracer_devmode_sync()
+{
+  unsigned int i, n;
+
+  if (rbtracer.devmode_synced == rbtracer.devmode_serial)
+    return;
+
+  // classes were (re)defined since we last looked, so cached names and
+  // matches may be stale. this also releases classes pinned by the caches.
+  if (rbtracer.klass_tbl)
+    st_clear(rbtracer.klass_tbl);
+  rbtracer_patterns_clear();
+
+  for (i=0, n=0; i<rbtracer.list_size && n<rbtracer.num; i++) {
+    rbtracer_t *curr = &rbtracer.list[i];
+    if (!curr->query) continue;
+    n++;
+
+    if (curr->klass_cache)
+      st_clear(curr->klass_cache);
+  }
+
+  rbtracer.devmode_synced = rbtracer.devmode_serial;
+}
+
+static bool
+rbtracer_devmode_match(rbtracer_t *tracer, VALUE klass)
+{
+  st_data_t matched;
+
+  if (!tracer->klass_cache)
+    tracer->klass_cache = st_init_numtable();
+
+  if (st_lookup(tracer->klass_cache, (st_data_t)klass, &matched))
+    return matched;
+
+  const char *name = rb_class2name(klass);
+  matched = name && 0 == strncmp(name, tracer->klass_name, tracer->klass_len);
+
+  if (name && name[0] != '#')
+    st_insert(tracer->klass_cache, (st_data_t)klass, matched);
+
+  // classes reloaded without a class/module keyword (Foo = Class.new) never
+  // bump the serial, so start over before pinning too many of them
+  if (tracer->klass_cache->num_entries >= MAX_KLASS_CACHE)
+    rbtracer.devmode_serial++;
+
+  return matched;
+}
+
+static rbtracer_t *
+rbtracer_match(ID mid, VALUE klass, VALUE self, bool singleton)
+{
+  rbtracer_t *tracer = NULL;
+  unsigned int i, n;
+
+  for (i=0, n=0; i<rbtracer.list_size && n<rbtracer.num; i++) {
+    rbtracer_t *curr = &rbtracer.list[i];
+
+    if (curr->query) {
+      n++;
+
+      // there should never be slow method tracers outside slow mode
+      if (!rbtracer.slow && curr->is_slow) continue;
+
+      // matched below, through the pattern cache
+      if (curr->is_pattern) continue;
+
+      if (rbtracer.devmode) {
+        if ((!curr->mid        || curr->mid == mid) &&
+            (!curr->klass_name || (
+              (singleton == curr->is_singleton) &&
+              rbtracer_devmode_match(curr, singleton ? self : klass))))
+        {
+          tracer = curr;
+          break;
+        }
+      } else {
+        if ((!curr->mid   || curr->mid == mid) &&
+            (!curr->klass || curr->klass == klass) &&
+            (!curr->self  || curr->self == self))
+        {
+          tracer = curr;
+          break;
+        }
+      }
+    }
+  }
+
+  if (!tracer && rbtracer.num_patterns > 0)
+    tracer = rbtracer_pattern_lookup(singleton ? self : klass, singleton, mid);
+
+  return tracer;
+}
+
+// Log-linear histogram of durations in usec: each power of two is split into
+// HIST_SUB buckets, so any value is within 25% of its bucket's bounds.
+#define HIST_SUB_BITS 2
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1) * HIST_SUB)
+
+typedef struct {
+  uint32_t count;
+  uint32_t buckets[HIST_BUCKETS];
+} histogram_t;
+
+static int
+histogram__bucket(uint64_t usec)
+{
+  if (usec < HIST_SUB)
+    return (int)usec;
+
+  int shift = 63 - __builtin_clzll(usec) - HIST_SUB_BITS;
+  return (shift + 1) * HIST_SUB + (int)((usec >> shift) & (HIST_SUB - 1));
+}
+
+// The largest value that falls into a bucket.
+static uint64_t
+histogram__upper(int bucket)
+{
+  if (bucket < HIST_SUB)
+    return bucket;
+
+  int shift = bucket / HIST_SUB - 1;
+  return (((uint64_t)(HIST_SUB + bucket % HIST_SUB) + 1) << shift) - 1;
+}
+
+static void
+histogram_add(histogram_t *h, uint64_t usec)
+{
+  h->buckets[ histogram__bucket(usec) ]++;
+  h->count++;
+}
+
+// Halve every bucket, so old samples fade out as new ones come in.
+static void
+histogram_decay(histogram_t *h)
+{
+  int i;
+
+  h->count = 0;
+  for (i=0; i<HIST_BUCKETS; i++) {
+    h->buckets[i] /= 2;
+    h->count += h->buckets[i];
+  }
+}
+
+static uint64_t
+histogram_quantile(histogram_t *h, double q)
+{
+  uint64_t rank = (uint64_t)(q * h->count + 0.5), seen = 0;
+  int i;
+
+  for (i=0; i<HIST_BUCKETS; i++) {
+    seen += h->buckets[i];
+    if (seen >= rank && seen > 0)
+      return histogram__upper(i);
+  }
+
+  return 0;
+}
+
+// In adaptive slow mode every method keeps a histogram of its own durations,
+// and a call is only reported when it is slower than that method's quantile
+// (or a multiple of its median), once enough calls have been seen.
+#define ADAPTIVE_WARMUP 100     // calls seen before a method can be reported
+#define ADAPTIVE_REFRESH 64     // calls between threshold updates
+#define ADAPTIVE_DECAY 16384    // histograms are halved at this many calls
+#define MAX_ADAPTIVE 4096       // methods tracked at once
+
+typedef struct {
+  uint64_t threshold; // usec
+  uint32_t seen;
+  histogram_t hist;
+} adaptive_stat_t;
+
+static struct {
+  bool enabled;
+  double quantile;
+  unsigned int multiplier; // of the median, instead of a quantile
+  unsigned int num;
+
+  // (klass|singleton) -> mid -> adaptive_stat_t
+  st_table *tbl;
+}
+adaptive = {
+  .enabled = false,
+  .quantile = 0.99,
+  .multiplier = 0,
+  .num = 0,
+  .tbl = NULL,
+};
+
+static int
+adaptive__free_stat(st_data_t key, st_data_t val, st_data_t arg)
+{
+  free((void *)val);
+  return ST_CONTINUE;
+}
+
+static int
+adaptive__free_mids(st_data_t key, st_data_t val, st_data_t arg)
+{
+  st_foreach((st_table *)val, adaptive__free_stat, 0);
+  st_free_table((st_table *)val);
+  return ST_CONTINUE;
+}
+
+static void
+adaptive_clear()
+{
+  if (adaptive.tbl) {
+    st_foreach(adaptive.tbl, adaptive__free_mids, 0);
+    st_clear(adaptive.tbl);
+  }
+  adaptive.num = 0;
+}
+
+static adaptive_stat_t *
+adaptive__lookup(VALUE klass, bool singleton, ID mid)
+{
+  st_data_t key = (st_data_t)klass | singleton;
+  st_data_t mids, stat;
+
+  if (!adaptive.tbl)
+    adaptive.tbl = st_init_numtable();
+
+  if (!st_lookup(adaptive.tbl, key, &mids)) {
+    if (adaptive.num >= MAX_ADAPTIVE || adaptive.tbl->num_entries >= MAX_KLASS_CACHE)
+      adaptive_clear();
+
+    mids = (st_data_t)st_init_numtable();
+    st_insert(adaptive.tbl, key, mids);
+  }
+
+  if (!st_lookup((st_table *)mids, (st_data_t)mid, &stat)) {
+    if (adaptive.num >= MAX_ADAPTIVE) {
+      adaptive_clear();
+      return adaptive__lookup(klass, singleton, mid);
+    }
+
+    stat = (st_data_t)calloc(1, sizeof(adaptive_stat_t));
+    if (!stat)
+      return NULL;
+
+    st_insert((st_table *)mids, (st_data_t)mid, stat);
+    adaptive.num++;
+  }
+
+  return (adaptive_stat_t *)stat;
+}
+
+// Records a call's duration, and returns the threshold it should be compared
+// against, or 0 if the method is still warming up.
+static uint64_t
+adaptive_sample(VALUE klass, bool singleton, ID mid, uint64_t usec)
+{
+  adaptive_stat_t *stat = adaptive__lookup(klass, singleton, mid);
+  if (!stat)
+    return 0;
+
+  // compare against the threshold from before this call
+  uint64_t threshold = stat->seen >= ADAPTIVE_WARMUP ? stat->threshold : 0;
+
+  histogram_add(&stat->hist, usec);
+  stat->seen++;
+
+  if (stat->hist.count >= ADAPTIVE_DECAY)
+    histogram_decay(&stat->hist);
+
+  if (stat->seen % ADAPTIVE_REFRESH == 0 || stat->seen == ADAPTIVE_WARMUP) {
+    if (adaptive.multiplier)
+      stat->threshold = histogram_quantile(&stat->hist, 0.5) * adaptive.multiplier;
+    else
+      stat->threshold = histogram_quantile(&stat->hist, adaptive.quantile);
+  }
+
+  return threshold;
+}
+
+static void
+adaptive_start(unsigned int permille, unsigned int multiplier)
+{
+  adaptive_clear();
+  adaptive.quantile = permille / 1000.0;
+  adaptive.multiplier = multiplier;
+  adaptive.enabled = true;
+}
+
+static void
+adaptive_stop()
+{
+  adaptive.enabled = false;
+  adaptive_clear();
+  if (adaptive.tbl)
+    st_free_table(adaptive.tbl);
+  adaptive.tbl = NULL;
+}
+
+// Tail-based capture buffers every call and return below a root call, and
+// only sends them once the root returns, if it took longer than the
+// threshold. Roots are traced methods, or the outermost calls otherwise.
+// Each thread buffers its own tree. Once a buffer is full, further subtrees
+// are left out, while keeping room for the returns of the calls already in it.
+#define TAIL_MAX_EVENTS 65536
+
+typedef struct tail_event {
+  bool call;
+  bool cfunc;
+  bool singleton;
+  uint64_t time;
+  ID mid;
+  VALUE klass;
+} tail_event_t;
+
+static struct {
+  bool enabled;
+  uint64_t threshold; // usec
+}
+tail = {
+  .enabled = false,
+  .threshold = 0
+};
+
+static bool
+tail__push(rbtrace_local_t *local, bool call, bool cfunc, ID mid, VALUE klass, bool singleton)
+{
+  // every buffered call needs room for its return too
+  if (call && local->tail_num + local->tail_open + 2 > TAIL_MAX_EVENTS)
+    return false;
+
+  if (local->tail_num == local->tail_size) {
+    unsigned int size = local->tail_size ? local->tail_size * 2 : 1024;
+    tail_event_t *events = realloc(local->tail_events, size * sizeof(tail_event_t));
+    if (!events) return false;
+
+    local->tail_events = events;
+    local->tail_size = size;
+  }
+
+  tail_event_t *ev = &local->tail_events[ local->tail_num++ ];
+  ev->call = call;
+  ev->cfunc = cfunc;
+  ev->singleton = singleton;
+  ev->time = timeofday_usec();
+  ev->mid = mid;
+  ev->klass = klass;
+
+  return true;
+}
+
+// Queuing for the writer must not wait in the hook, and a tree can be larger
+// than its ring. So once the ring runs low, the remaining subtrees are left
+// out, and only the returns of calls already sent follow.
+#define TAIL_EVENT_SIZE 32   // room a return takes, at most
+#define TAIL_CALL_ROOM  4096 // room left for a call and its names
+
+static void
+tail_send(rbtrace_local_t *local)
+{
+  unsigned int i, depth = 0, skip = 0;
+  uint32_t skipped = local->tail_skipped;
+
+  for (i=0; i<local->tail_num; i++) {
+    tail_event_t *ev = &local->tail_events[i];
+
+    if (ev->call) {
+      depth++;
+
+      if (!skip && writer_room() < (size_t)depth * TAIL_EVENT_SIZE + TAIL_CALL_ROOM)
+        skip = depth;
+
+      if (skip) {
+        skipped++;
+        continue;
+      }
+
+      rbtrace__send_names(ev->mid, ev->klass);
+      rbtrace__send_event(5,
+        ev->cfunc ? "ccall" : "call",
+        't', ev->time,
+        'd', -1,
+        'l', ev->mid,
+        'b', ev->singleton,
+        'l', ev->klass
+      );
+    } else {
+      depth--;
+
+      if (skip) {
+        if (depth < skip)
+          skip = 0;
+        continue;
+      }
+
+      rbtrace__send_event(2,
+        ev->cfunc ? "creturn" : "return",
+        't', ev->time,
+        'd', -1
+      );
+    }
+  }
+
+  if (skipped) {
+    rbtrace__send_event(1,
+      "truncated",
+      'u', skipped
+    );
+  }
+}
+
+static void
+tail_hook(rbtrace_local_t *local, bool call, bool cfunc, ID mid, VALUE klass, VALUE self, bool singleton)
+{
+  if (local->tail_depth == 0) {
+    if (!call) return;
+    if (rbtracer.num > 0 && !rbtracer_match(mid, klass, self, singleton)) return;
+
+    local->tail_num = local->tail_open = local->tail_skip = local->tail_skipped = 0;
+  }
+
+  if (call) {
+    local->tail_depth++;
+
+    if (local->tail_skip) {
+      local->tail_skipped++;
+    } else if (tail__push(local, true, cfunc, mid, singleton ? self : klass, singleton)) {
+      local->tail_open++;
+    } else {
+      local->tail_skip = local->tail_depth;
+      local->tail_skipped++;
+    }
+    return;
+  }
+
+  if (local->tail_skip) {
+    if (local->tail_depth == local->tail_skip)
+      local->tail_skip = 0;
+  } else {
+    tail__push(local, false, cfunc, 0, 0, false);
+    local->tail_open--;
+  }
+
+  if (--local->tail_depth > 0)
+    return;
+
+  // the root returned
+  if (local->tail_num > 0 &&
+      local->tail_events[ local->tail_num-1 ].time - local->tail_events[0].time > tail.threshold)
+    tail_send(local);
+
+  local->tail_num = 0;
+}
+
+// Drops every thread's open tree, and frees its buffer unless keep is set.
+static void
+tail_clear(bool keep)
+{
+  rbtrace_local_t *local;
+
+  locals_lock();
+  for (local = locals; local; local = local->next) {
+    local->tail_depth = local->tail_num = 0;
+
+    if (!keep) {
+      free(local->tail_events);
+      local->tail_events = NULL;
+      local->tail_size = 0;
+    }
+  }
+  locals_unlock();
+}
+
+static void
+tail_start(uint32_t msec)
+{
+  tail.threshold = (uint64_t)msec * 1000;
+  tail_clear(true);
+  tail.enabled = true;
+}
+
+static void
+tail_stop()
+{
+  tail.enabled = false;
+  tail_clear(false);
+}
+
+// GVL mode follows every thread through acquiring (READY), holding (RESUMED)
+// and releasing (SUSPENDED) the GVL, and keeps histograms of time spent
+// waiting for it, running, and blocked without it. Waits are also charged
+// to the innermost traced method on the waiting thread's stack. All updates
+// happen in hooks that run with the GVL held, except for READY, which only
+// touches its own thread's state.
+#ifdef HAVE_RB_INTERNAL_THREAD_SPECIFIC_GET
+#define GVL_STACK 64          // traced methods remembered per thread
+#define GVL_MAX_METHODS 1024  // traced methods waits are charged to
+
+typedef struct gvl_thread {
+  struct gvl_thread *next;
+  VALUE thread;
+  bool exited;
+
+  uint64_t ready_at, resumed_at, suspended_at;
+  uint64_t wait, run, blocked; // usec since the last dump
+
+  int depth;
+  int stack[GVL_STACK]; // indexes into gvl.methods, or -1
+} gvl_thread_t;
+
+typedef struct {
+  ID mid;
+  VALUE klass;
+  bool singleton;
+  uint64_t wait;
+  uint32_t count;
+} gvl_method_t;
+
+static struct {
+  bool enabled;
+  bool key_created;
+  rb_internal_thread_specific_key_t key;
+  rb_internal_thread_event_hook_t *hook;
+  uint64_t since;
+
+  gvl_thread_t *threads;
+  histogram_t wait, run, blocked;
+  uint64_t wait_total, run_total, blocked_total;
+
+  unsigned int num_methods;
+  gvl_method_t methods[GVL_MAX_METHODS];
+}
+gvl = {
+  .enabled = false,
+  .key_created = false,
+  .hook = NULL,
+  .threads = NULL,
+  .num_methods = 0,
+};
+
+// Only called with the GVL held.
+static gvl_thread_t *
+gvl__thread(VALUE thread)
+{
+  gvl_thread_t *t = rb_internal_thread_specific_get(thread, gvl.key);
+
+  if (!t && (t = calloc(1, sizeof(gvl_thread_t)))) {
+    t->thread = thread;
+    t->next = gvl.threads;
+    gvl.threads = t;
+    rb_internal_thread_specific_set(thread, gvl.key, t);
+  }
+
+  return t;
+}
+
+static int
+gvl__method(ID mid, VALUE klass, bool singleton)
+{
+  unsigned int h = (unsigned int)((mid * 31 + (klass >> 3)) % GVL_MAX_METHODS), i;
+
+  for (i=0; i<GVL_MAX_METHODS; i++, h = (h + 1) % GVL_MAX_METHODS) {
+    gvl_method_t *m = &gvl.methods[h];
+
+    if (m->mid == mid && m->klass == klass && m->singleton == singleton)
+      return h;
+
+    if (!m->mid) {
+      m->mid = mid;
+      m->klass = klass;
+      m->singleton = singleton;
+      gvl.num_methods++;
+      return h;
+    }
+  }
+
+  return -1;
+}
+
+static void
+gvl_thread_hook(rb_event_flag_t event, const rb_internal_thread_event_data_t *data, void *arg)
+{
+  gvl_thread_t *t;
+  uint64_t usec = timeofday_usec();
+
+  if (event == RUBY_INTERNAL_THREAD_EVENT_READY) {
+    // no GVL here, so never allocate and only touch this thread's state
+    if ((t = rb_internal_thread_specific_get(data->thread, gvl.key)))
+      t->ready_at = usec;
+    return;
+  }
+
+  if (event == RUBY_INTERNAL_THREAD_EVENT_EXITED) {
+    if ((t = rb_internal_thread_specific_get(data->thread, gvl.key)))
+      __atomic_store_n(&t->exited, true, __ATOMIC_RELEASE);
+    return;
+  }
+
+  if (!(t = gvl__thread(data->thread)))
+    return;
+
+  if (event == RUBY_INTERNAL_THREAD_EVENT_RESUMED) {
+    // threads giving up their time slice want the GVL back right away, and
+    // do not always say so
+    if (!t->ready_at)
+      t->ready_at = t->suspended_at;
+
+    if (t->ready_at) {
+      uint64_t wait = usec - t->ready_at;
+      histogram_add(&gvl.wait, wait);
+      gvl.wait_total += wait;
+      t->wait += wait;
+
+      if (t->depth > 0) {
+        int m = t->stack[ (t->depth < GVL_STACK ? t->depth : GVL_STACK) - 1 ];
+        if (m != -1) {
+          gvl.methods[m].wait += wait;
+          gvl.methods[m].count++;
+        }
+      }
+
+      if (t->suspended_at && t->suspended_at <= t->ready_at) {
+        uint64_t blocked = t->ready_at - t->suspended_at;
+        histogram_add(&gvl.blocked, blocked);
+        gvl.blocked_total += blocked;
+        t->blocked += blocked;
+      }
+    }
+
+    t->ready_at = 0;
+    t->resumed_at = usec;
+
+  } else if (event == RUBY_INTERNAL_THREAD_EVENT_SUSPENDED) {
+    if (t->resumed_at) {
+      uint64_t run = usec - t->resumed_at;
+      histogram_add(&gvl.run, run);
+      gvl.run_total += run;
+      t->run += run;
+    }
+
+    t->resumed_at = 0;
+    t->suspended_at = usec;
+  }
+}
+
+// Tracks the traced methods on the current thread's stack.
+static void
+gvl_hook(bool call, ID mid, VALUE klass, VALUE self, bool singleton)
+{
+  gvl_thread_t *t = gvl__thread(rb_thread_current());
+  if (!t)
+    return;
+
+  if (call) {
+    if (!rbtracer_match(mid, klass, self, singleton))
+      return;
+
+    if (t->depth < GVL_STACK)
+      t->stack[ t->depth ] = gvl__method(mid, singleton ? self : klass, singleton);
+    t->depth++;
+
+  } else if (t->depth > 0) {
+    int top = t->depth <= GVL_STACK ? t->stack[ t->depth-1 ] : -1;
+
+    // only pop when returning from the method we pushed
+    if (top == -1 ? rbtracer_match(mid, klass, self, singleton) != NULL :
+        gvl.methods[top].mid == mid && gvl.methods[top].klass == (singleton ? self : klass))
+      t->depth--;
+  }
+}
+
+static void
+gvl__send_hist(const char *kind, histogram_t *h, uint64_t total)
+{
+  int64_t bounds[HIST_BUCKETS], counts[HIST_BUCKETS];
+  int i, n = 0;
+
+  // two packed integers per bucket, at most
+  writer_wait(HIST_BUCKETS * 18 + 64);
+
+  for (i=0; i<HIST_BUCKETS; i++) {
+    if (h->buckets[i]) {
+      bounds[n] = histogram__upper(i);
+      counts[n] = h->buckets[i];
+      n++;
+    }
+  }
+
+  rbtrace__send_event(5,
+    "gvlhist",
+    's', kind,
+    'u', h->count,
+    't', total,
+    'a', n, bounds,
+    'a', n, counts
+  );
+
+  memset(h, 0, sizeof(*h));
+}
+
+// Sends everything collected since the last dump, and starts over.
+static void
+gvl_dump()
+{
+  gvl_thread_t **p = &gvl.threads, *t;
+  unsigned int i;
+
+  if (!gvl.enabled)
+    return;
+
+  gvl__send_hist("wait", &gvl.wait, gvl.wait_total);
+  gvl__send_hist("run", &gvl.run, gvl.run_total);
+  gvl__send_hist("blocked", &gvl.blocked, gvl.blocked_total);
+  gvl.wait_total = gvl.run_total = gvl.blocked_total = 0;
+
+  // waiting on the writer lets other threads run, and maybe exit, so each
+  // thread is only looked at once there is room for it. Nothing but this
+  // frees a thread's entry, and new ones are added in front.
+  while ((t = *p)) {
+    writer_wait(1024);
+
+    if (__atomic_load_n(&t->exited, __ATOMIC_ACQUIRE)) {
+      *p = t->next;
+      free(t);
+      continue;
+    }
+
+    if (t->wait || t->run || t->blocked) {
+      VALUE desc = rb_inspect(t->thread);
+      rbtrace__send_event(4,
+        "gvlthread",
+        's', StringValueCStr(desc),
+        't', t->wait,
+        't', t->run,
+        't', t->blocked
+      );
+      t->wait = t->run = t->blocked = 0;
+    }
+
+    p = &t->next;
+  }
+
+  for (i=0; i<GVL_MAX_METHODS; i++) {
+    gvl_method_t *m = &gvl.methods[i];
+    if (!m->count) continue;
+
+    writer_wait(1024);
+    rbtrace__send_names(m->mid, m->klass);
+    rbtrace__send_event(5,
+      "gvlmethod",
+      'l', m->mid,
+      'b', m->singleton,
+      'l', m->klass,
+      't', m->wait,
+      'u', m->count
+    );
+    m->wait = m->count = 0;
+  }
+
+  writer_wait(64);
+  uint64_t usec = timeofday_usec();
+  rbtrace__send_event(1,
+    "gvldone",
+    't', usec - gvl.since
+  );
+  gvl.since = usec;
+}
+
+static void
+gvl_stop()
+{
+  gvl_thread_t *t;
+
+  if (!gvl.enabled)
+    return;
+
+  // no hooks are running once this returns
+  rb_internal_thread_remove_event_hook(gvl.hook);
+  gvl.hook = NULL;
+  gvl.enabled = false;
+
+  while ((t = gvl.threads)) {
+    if (!t->exited)
+      rb_internal_thread_specific_set(t->thread, gvl.key, NULL);
+    gvl.threads = t->next;
+    free(t);
+  }
+
+  memset(gvl.methods, 0, sizeof(gvl.methods));
+  gvl.num_methods = 0;
+}
+
+static bool
+gvl_start()
+{
+  if (gvl.enabled)
+    return true;
+
+  if (!gvl.key_created) {
+    gvl.key = rb_internal_thread_specific_key_create();
+    gvl.key_created = true;
+  }
+
+  memset(&gvl.wait, 0, sizeof(gvl.wait));
+  memset(&gvl.run, 0, sizeof(gvl.run));
+  memset(&gvl.blocked, 0, sizeof(gvl.blocked));
+  gvl.wait_total = gvl.run_total = gvl.blocked_total = 0;
+  gvl.since = timeofday_usec();
+
+  gvl.hook = rb_internal_thread_add_event_hook(gvl_thread_hook,
+    RUBY_INTERNAL_THREAD_EVENT_READY |
+    RUBY_INTERNAL_THREAD_EVENT_RESUMED |
+    RUBY_INTERNAL_THREAD_EVENT_SUSPENDED |
+    RUBY_INTERNAL_THREAD_EVENT_EXITED,
+    NULL);
+  gvl.enabled = true;
+
+  // the current thread holds the GVL already, and will not see a RESUMED
+  gvl__thread(rb_thread_current())->resumed_at = gvl.since;
+  return true;
+}
+#else
+static struct {
+  bool enabled;
+} gvl = {
+  .enabled = false,
+};
+
+static void
+gvl_hook(bool call, ID mid, VALUE klass, VALUE self, bool singleton)
+{
+}
+
+static void
+gvl_dump()
+{
+}
+
+static void
+gvl_stop()
+{
+}
+
+static bool
+gvl_start()
+{
+  return false;
+}
+#endif
+
+// I/O mode times blocking calls on IO objects (and IO.select), without
+// sending anything per call. Calls are aggregated by what they were blocked
+// on (a path, peer address or kind of fd), the method, and the ruby method
+// that called it, and sent on request as histograms. Only the outermost I/O
+// call on each thread is timed.
+#define IO_MAX_TARGETS 512
+#define IO_MAX_STATS 512
+
+typedef struct {
+  int target;
+  ID mid;
+  VALUE klass;
+  bool singleton;
+  VALUE caller; // profile frame, or Qnil
+  uint64_t total, max;
+  histogram_t hist;
+} io_stat_t;
+
+typedef struct {
+  int depth;
+  uint64_t start;
+  int target;
+  ID mid;
+  VALUE self; // receiver of the outermost call
+  VALUE klass;
+  bool singleton;
+  VALUE caller;
+} io_thread_t;
+
+static struct {
+  bool enabled;
+  uint64_t since;
+
+  // IO object -> target index, IO objects are kept alive until the next dump
+  st_table *io_tbl;
+  // thread -> io_thread_t
+  st_table *thread_tbl;
+  // method ids that can block
+  st_table *mid_tbl;
+
+  int num_targets;
+  char (*targets)[128];
+
+  int num_stats;
+  io_stat_t *stats;
+
+  // stats and targets set aside while they are being sent
+  io_stat_t *dump;
+  char (*dump_targets)[128];
+}
+io = {
+  .enabled = false,
+  .io_tbl = NULL,
+  .thread_tbl = NULL,
+  .mid_tbl = NULL,
+  .num_targets = 0,
+  .targets = NULL,
+  .num_stats = 0,
+  .stats = NULL,
+  .dump = NULL,
+  .dump_targets = NULL,
+};
+
+static const char *io_methods[] = {
+  "read", "readpartial", "sysread", "pread", "gets", "getc", "getbyte",
+  "readline", "readlines", "readchar", "readbyte", "each_line",
+  "write", "syswrite", "pwrite", "print", "puts", "printf", "<<", "flush", "fsync",
+  "recv", "recvfrom", "recvmsg", "send", "sendmsg",
+  "accept", "sysaccept", "connect", "wait", "wait_readable", "wait_writable",
+  "select", NULL
+};
+
+static VALUE
+io__fileno(VALUE self)
+{
+  return rb_funcall(self, rb_intern("fileno"), 0);
+}
+
+static VALUE
+io__path(VALUE self)
+{
+  return rb_funcall(self, rb_intern("path"), 0);
+}
+
+static void
+io__describe(VALUE self, char *buf, size_t size)
+{
+  struct stat st;
+  union {
+    struct sockaddr sa;
+    struct sockaddr_in in;
+    struct sockaddr_in6 in6;
+    struct sockaddr_un un;
+  } addr;
+  socklen_t len = sizeof(addr);
+  char host[INET6_ADDRSTRLEN];
+
+  // ruby/io.h clashes with regex.h, so ask the IO itself
+  int state = 0;
+  VALUE val = rb_protect(io__fileno, self, &state);
+  if (state || !FIXNUM_P(val)) {
+    rb_set_errinfo(Qnil);
+    snprintf(buf, size, "closed");
+    return;
+  }
+
+  int fd = FIX2INT(val);
+  VALUE path = Qnil;
+  if (rb_obj_is_kind_of(self, rb_cFile)) {
+    path = rb_protect(io__path, self, &state);
+    if (state || TYPE(path) != T_STRING) {
+      rb_set_errinfo(Qnil);
+      path = Qnil;
+    }
+  }
+
+  if (0 == getpeername(fd, &addr.sa, &len)) {
+    if (addr.sa.sa_family == AF_INET && inet_ntop(AF_INET, &addr.in.sin_addr, host, sizeof(host)))
+      snprintf(buf, size, "fd %d %s:%d", fd, host, ntohs(addr.in.sin_port));
+    else if (addr.sa.sa_family == AF_INET6 && inet_ntop(AF_INET6, &addr.in6.sin6_addr, host, sizeof(host)))
+      snprintf(buf, size, "fd %d [%s]:%d", fd, host, ntohs(addr.in6.sin6_port));
+    else if (addr.sa.sa_family == AF_UNIX && len > offsetof(struct sockaddr_un, sun_path) && addr.un.sun_path[0])
+      snprintf(buf, size, "fd %d unix:%.*s", fd, (int)(len - offsetof(struct sockaddr_un, sun_path)), addr.un.sun_path);
+    else
+      snprintf(buf, size, "fd %d (socket)", fd);
+
+  } else if (!NIL_P(path)) {
+    snprintf(buf, size, "fd %d %.*s", fd, (int)RSTRING_LEN(path), RSTRING_PTR(path));
+
+  } else if (0 == fstat(fd, &st)) {
+    snprintf(buf, size, "fd %d (%s)", fd,
+      S_ISFIFO(st.st_mode) ? "pipe" :
+      S_ISSOCK(st.st_mode) ? "socket" :
+      S_ISCHR(st.st_mode)  ? (isatty(fd) ? "tty" : "char device") :
+      S_ISREG(st.st_mode)  ? "file" : "fd");
+
+  } else {
+    snprintf(buf, size, "fd %d", fd);
+  }
+}
+
+static int
+io__target(VALUE self)
+{
+  st_data_t target;
+
+  if (st_lookup(io.io_tbl, (st_data_t)self, &target))
+    return (int)target;
+
+  if (io.num_targets >= IO_MAX_TARGETS)
+    return -1;
+
+  target = io.num_targets++;
+  if (TYPE(self) == T_FILE)
+    io__describe(self, io.targets[target], sizeof(io.targets[0]));
+  else
+    snprintf(io.targets[target], sizeof(io.targets[0]), "(no fd)"); // IO.select, File.read
+
+  st_insert(io.io_tbl, (st_data_t)self, target);
+  return (int)target;
+}
+
+static io_stat_t *
+io__stat(io_thread_t *t)
+{
+  unsigned int h = (unsigned int)((t->target * 31 + t->mid * 17 + (t->klass >> 3) + (t->caller >> 3)) % IO_MAX_STATS), i;
+
+  for (i=0; i<IO_MAX_STATS; i++, h = (h + 1) % IO_MAX_STATS) {
+    io_stat_t *stat = &io.stats[h];
+
+    if (stat->mid == t->mid && stat->target == t->target && stat->klass == t->klass &&
+        stat->singleton == t->singleton && stat->caller == t->caller)
+      return stat;
+
+    if (!stat->mid) {
+      stat->target = t->target;
+      stat->mid = t->mid;
+      stat->klass = t->klass;
+      stat->singleton = t->singleton;
+      stat->caller = t->caller;
+      io.num_stats++;
+      return stat;
+    }
+  }
+
+  return NULL;
+}
+
+// The ruby method that made the I/O call, skipping the cfunc itself.
+static VALUE
+io__caller()
+{
+#ifdef HAVE_RB_PROFILE_FRAMES
+  VALUE frames[3];
+  int lines[3], n, i;
+
+  n = rb_profile_frames(0, 3, frames, lines);
+  for (i=0; i<n; i++)
+    if (!NIL_P(rb_profile_frame_path(frames[i])))
+      return frames[i];
+#endif
+
+  return Qnil;
+}
+
+static void
+io_hook(bool call, ID mid, VALUE self, bool singleton)
+{
+  st_data_t data;
+  io_thread_t *t;
+  VALUE thread = rb_thread_current();
+
+  if (!st_is_member(io.mid_tbl, (st_data_t)mid))
+    return;
+  // String#<< and Kernel#puts share names with IO methods
+  if (singleton ? !RTEST(rb_class_inherited_p(self, rb_cIO)) : !rb_obj_is_kind_of(self, rb_cIO))
+    return;
+
+  if (call) {
+
+    if (!st_lookup(io.thread_tbl, (st_data_t)thread, &data)) {
+      if (!(t = calloc(1, sizeof(io_thread_t))))
+        return;
+      st_insert(io.thread_tbl, (st_data_t)thread, (st_data_t)t);
+    } else {
+      t = (io_thread_t *)data;
+    }
+
+    // puts calls write, and so on
+    if (t->depth++ > 0)
+      return;
+
+    t->target = io__target(self);
+    t->self = self;
+    t->mid = mid;
+    t->klass = singleton ? self : rb_obj_class(self);
+    t->singleton = singleton;
+    t->caller = io__caller();
+    t->start = timeofday_usec();
+
+  } else {
+    if (!st_lookup(io.thread_tbl, (st_data_t)thread, &data))
+      return;
+    t = (io_thread_t *)data;
+
+    if (t->depth == 0)
+      return;
+    if (--t->depth > 0 || t->target == -1 || mid != t->mid || self != t->self)
+      return;
+
+    uint64_t diff = timeofday_usec() - t->start;
+    io_stat_t *stat = io__stat(t);
+    if (!stat)
+      return;
+
+    histogram_add(&stat->hist, diff);
+    stat->total += diff;
+    if (diff > stat->max)
+      stat->max = diff;
+  }
+}
+
+static int
+io__free_thread(st_data_t key, st_data_t val, st_data_t arg)
+{
+  free((void *)val);
+  return ST_CONTINUE;
+}
+
+static void
+io__reset()
+{
+  st_foreach(io.thread_tbl, io__free_thread, 0);
+  st_clear(io.thread_tbl);
+  st_clear(io.io_tbl);
+  memset(io.stats, 0, IO_MAX_STATS * sizeof(io_stat_t));
+  io.num_stats = io.num_targets = 0;
+  io.since = timeofday_usec();
+}
+
+// Sends everything collected since the last dump, and starts over. The
+// stats are set aside first, so hooks on other threads can keep adding to
+// fresh ones while we wait for room to send them.
+static void
+io_dump()
+{
+  int64_t bounds[HIST_BUCKETS], counts[HIST_BUCKETS];
+  int i, j, n;
+
+  if (!io.enabled || io.dump)
+    return;
+
+  uint64_t usec = timeofday_usec(), since = io.since;
+  io_stat_t *stats = calloc(IO_MAX_STATS, sizeof(io_stat_t));
+  char (*targets)[128] = calloc(IO_MAX_TARGETS, sizeof(targets[0]));
+
+  if (stats && targets) {
+    io.dump = io.stats;
+    io.dump_targets = io.targets;
+    io.stats = stats;
+    io.targets = targets;
+  } else {
+    free(stats);
+    free(targets);
+  }
+  io__reset();
+
+  for (i=0; io.dump && i<IO_MAX_STATS; i++) {
+    io_stat_t *stat = &io.dump[i];
+    if (!stat->mid || !stat->hist.count) continue;
+
+    for (j=0, n=0; j<HIST_BUCKETS; j++) {
+      if (stat->hist.buckets[j]) {
+        bounds[n] = histogram__upper(j);
+        counts[n] = stat->hist.buckets[j];
+        n++;
+      }
+    }
+
+    VALUE caller = Qnil;
+    if (!NIL_P(stat->caller))
+      caller = rb_sprintf("%"PRIsVALUE":in `%"PRIsVALUE"'",
+        rb_profile_frame_path(stat->caller), rb_profile_frame_full_label(stat->caller));
+
+    writer_wait(1024 + n * 18);
+    rbtrace__send_names(stat->mid, stat->klass);
+    rbtrace__send_event(9,
+      "iostat",
+      's', io.dump_targets[stat->target],
+      'l', stat->mid,
+      'b', stat->singleton,
+      'l', stat->klass,
+      's', NIL_P(caller) ? NULL : StringValueCStr(caller),
+      't', stat->total,
+      't', stat->max,
+      'a', n, bounds,
+      'a', n, counts
+    );
+  }
+
+  writer_wait(64);
+  rbtrace__send_event(1,
+    "iodone",
+    't', usec - since
+  );
+
+  free(io.dump);
+  free(io.dump_targets);
+  io.dump = NULL;
+  io.dump_targets = NULL;
+}
+
+static void
+io_stop()
+{
+  if (!io.enabled)
+    return;
+
+  io.enabled = false;
+  io__reset();
+
+  st_free_table(io.thread_tbl);
+  st_free_table(io.io_tbl);
+  st_free_table(io.mid_tbl);
+  io.thread_tbl = io.io_tbl = io.mid_tbl = NULL;
+
+  free(io.targets);
+  free(io.stats);
+  io.targets = NULL;
+  io.stats = NULL;
+}
+
+static void
+io_start()
+{
+  int i;
+
+  if (io.enabled)
+    return;
+
+  io.targets = calloc(IO_MAX_TARGETS, sizeof(io.targets[0]));
+  io.stats = calloc(IO_MAX_STATS, sizeof(io_stat_t));
+  if (!io.targets || !io.stats) {
+    free(io.targets);
+    free(io.stats);
+    io.targets = NULL;
+    io.stats = NULL;
+    return;
+  }
+
+  io.thread_tbl = st_init_numtable();
+  io.io_tbl = st_init_numtable();
+  io.mid_tbl = st_init_numtable();
+  for (i=0; io_methods[i]; i++)
+    st_insert(io.mid_tbl, (st_data_t)rb_intern(io_methods[i]), 1);
+
+  io.since = timeofday_usec();
+  io.enabled = true;
+}
+
+#define INSPECT_DEPTH 8 // nesting inspected piecewise, deeper values are inspected whole
+
+typedef struct {
+  VALUE val;
+  VALUE out;
+  long max;
+  int depth;
+  bool first; // no pair of the hash being inspected appended yet
+} rbtracer_inspect_t;
+
+static void
+rbtracer__inspect_into(rbtracer_inspect_t *insp, VALUE val);
+
+static int
+rbtracer__inspect_pair(VALUE key, VALUE val, VALUE arg)
+{
+  rbtracer_inspect_t *insp = (rbtracer_inspect_t *)arg;
+
+  if (RSTRING_LEN(insp->out) >= insp->max)
+    return ST_STOP;
+
+  if (!insp->first)
+    rb_str_cat2(insp->out, ", ");
+  insp->first = false;
+
+  rbtracer__inspect_into(insp, key);
+  rb_str_cat2(insp->out, "=>");
+  rbtracer__inspect_into(insp, val);
+
+  return ST_CONTINUE;
+}
+
+// Appends val inspected to insp->out, stopping once that is longer than
+// insp->max. Plain strings, arrays and hashes are inspected a piece at a
+// time, so a large one is never turned into a string as a whole.
+static void
+rbtracer__inspect_into(rbtracer_inspect_t *insp, VALUE val)
+{
+  VALUE klass = rb_obj_class(val);
+  long i;
+
+  if (RSTRING_LEN(insp->out) >= insp->max)
+    return;
+
+  insp->depth++;
+
+  if (insp->depth > INSPECT_DEPTH) {
+    rb_str_append(insp->out, rb_inspect(val));
+
+  } else if (klass == rb_cString) {
+    if (RSTRING_LEN(val) > insp->max)
+      val = rb_str_substr(val, 0, insp->max);
+    rb_str_append(insp->out, rb_inspect(val));
+
+  } else if (klass == rb_cArray) {
+    rb_str_cat2(insp->out, "[");
+    for (i=0; i<RARRAY_LEN(val) && RSTRING_LEN(insp->out) < insp->max; i++) {
+      if (i > 0)
+        rb_str_cat2(insp->out, ", ");
+      rbtracer__inspect_into(insp, RARRAY_AREF(val, i));
+    }
+    rb_str_cat2(insp->out, "]");
+
+  } else if (klass == rb_cHash) {
+    bool first = insp->first;
+
+    insp->first = true;
+    rb_str_cat2(insp->out, "{");
+    rb_hash_foreach(val, rbtracer__inspect_pair, (VALUE)insp);
+    rb_str_cat2(insp->out, "}");
+    insp->first = first;
+
+  } else {
+    rb_str_append(insp->out, rb_inspect(val));
+  }
+
+  insp->depth--;
+}
+
+static VALUE
+rbtracer__inspect_protected(VALUE arg)
+{
+  rbtracer_inspect_t *insp = (rbtracer_inspect_t *)arg;
+
+  if (!insp->max)
+    return rb_inspect(insp->val);
+
+  insp->out = rb_str_buf_new(64);
+  rbtracer__inspect_into(insp, insp->val);
+
+  return insp->out;
+}
+
+// Returns val inspected and cut down to max bytes (0 for no limit), or nil if
+// inspect raised.
+static VALUE
+rbtracer__inspect(VALUE val, long max)
+{
+  rbtracer_inspect_t insp = {val, Qnil, max, 0, false};
+  int state = 0;
+
+  VALUE str = rb_protect(rbtracer__inspect_protected, (VALUE)&insp, &state);
+
+  if (state) {
+    rb_set_errinfo(Qnil);
+    return Qnil;
+  }
+
+  if (max && RSTRING_LEN(str) > max) {
+    const char *ptr = RSTRING_PTR(str);
+    long len = max;
+
+    // don't leave half a utf-8 character behind
+    while (len > 0 && (ptr[len] & 0xC0) == 0x80)
+      len--;
+
+    str = rb_str_new(ptr, len);
+    rb_str_cat2(str, "...");
+  }
+
+  return str;
+}
+
+// Whether a tracer's expressions should be evaluated for this call: one in
+// every rbtracer.expr_sample calls, and at most expr_max_rate times a second.
+// Calls that are not are still traced, without the values.
+static bool
+rbtracer__expr_allowed(rbtracer_t *tracer)
+{
+  if (rbtracer.expr_sample > 1 && tracer->expr_calls++ % rbtracer.expr_sample)
+    return false;
+
+  if (rbtracer.expr_max_rate) {
+    uint64_t second = timeofday_usec() / 1000000;
+
+    if (second != tracer->expr_second) {
+      tracer->expr_second = second;
+      tracer->expr_evals = 0;
+    }
+
+    if (tracer->expr_evals >= rbtracer.expr_max_rate)
+      return false;
+    tracer->expr_evals++;
+  }
+
+  return true;
+}
+
+// Evaluates a tracer expression against self, and returns it inspected (as
+// a string, within rbtracer.expr_max_len), or as is.
+static VALUE
+rbtracer__expr(const char *expr, VALUE self, bool inspect)
+{
+  size_t len = strlen(expr);
+  char buffer[len+150];
+  VALUE val;
+
+  if (len == 4 && strcmp("self", expr) == 0) {
+    val = self;
+
+  } else if (len == 10 && strcmp("__source__", expr) == 0) {
+    return rb_sprintf(inspect ? "\"%s:%d\"" : "%s:%d", rb_sourcefile(), rb_sourceline());
+
+  } else if (len > 2 && expr[0] == '@' && expr[1] != '@') {
+    val = rb_ivar_get(self, rb_intern(expr));
+
+  } else {
+    int state = 0;
+
+    snprintf(buffer, len+150, "(begin; ObjectSpace._id2ref(%ld).instance_eval{ %s }; rescue Exception => e; e; end)", NUM2LONG(rb_obj_id(self)), expr);
+    val = rb_eval_string_protect(buffer, &state);
+
+    if (state)
+      return Qnil;
+  }
+
+  return inspect ? rbtracer__inspect(val, rbtracer.expr_max_len) : val;
+}
+
+// Aggregate mode sends no events per call. Instead, the values of a tracer's
+// expressions (e.g. the sql of an execute) are turned into a fingerprint with
+// literals taken out, and calls are timed and summed up per fingerprint. The
+// slowest fingerprints in total are sent on request.
+#define AGG_MAX 4096         // distinct fingerprints kept at once
+#define AGG_FINGERPRINT 1024 // bytes of a fingerprint kept
+#define AGG_STACK 32         // nested traced calls timed per thread
+
+typedef struct {
+  int tracer_id;
+  uint32_t count;
+  uint64_t total, max;
+  histogram_t hist;
+  char fingerprint[]; // "<tracer id> <fingerprint>", the table key
+} agg_stat_t;
+
+typedef struct {
+  int depth;
+  struct {
+    agg_stat_t *stat;
+    unsigned long generation;
+    uint64_t start;
+  } stack[AGG_STACK];
+} agg_thread_t;
+
+static struct {
+  bool enabled;
+  unsigned int top;
+  uint64_t since;
+  uint32_t other; // calls not counted, with the table full
+  unsigned long generation; // bumped whenever stats are freed
+
+  // fingerprint -> agg_stat_t
+  st_table *tbl;
+  // thread -> agg_thread_t
+  st_table *thread_tbl;
+}
+agg = {
+  .enabled = false,
+  .top = 20,
+  .other = 0,
+  .generation = 0,
+  .tbl = NULL,
+  .thread_tbl = NULL,
+};
+
+// Writes a normalized copy of str to out (at least len+1 bytes): quoted
+// strings and numbers become ?, lists of them a single ?, and whitespace is
+// collapsed. Works on sql as well as on inspected ruby arrays and hashes.
+static size_t
+agg__fingerprint(const char *str, long len, char *out)
+{
+  long i = 0;
+  size_t n = 0;
+
+  #define IDENT(c) (isalnum((unsigned char)(c)) || (c) == '_' || (c) == '$')
+  #define EMIT_LITERAL() do { \
+      /* "?, ?" and "?,?" collapse into "?" */ \
+      if (n >= 3 && out[n-1] == ' ' && out[n-2] == ',' && out[n-3] == '?') n -= 2; \
+      else if (n >= 2 && out[n-1] == ',' && out[n-2] == '?') n -= 1; \
+      else out[n++] = '?'; \
+    } while (0)
+
+  while (i < len) {
+    char c = str[i];
+
+    if (c == '\'' || c == '"' || c == '`') {
+      char quote = c;
+      // identifiers are quoted with backticks, keep them
+      if (quote == '`') {
+        do { out[n++] = str[i++]; } while (i < len && str[i] != '`');
+        if (i < len) out[n++] = str[i++];
+        continue;
+      }
+
+      for (i++; i < len; i++) {
+        if (str[i] == '\\') { i++; continue; }
+        if (str[i] == quote) {
+          // '' inside a sql string is an escaped quote
+          if (i+1 < len && str[i+1] == quote) { i++; continue; }
+          break;
+        }
+      }
+      i++;
+      EMIT_LITERAL();
+
+    } else if (isdigit((unsigned char)c) && (n == 0 || !IDENT(out[n-1]))) {
+      while (i < len && (isalnum((unsigned char)str[i]) || str[i] == '.'))
+        i++;
+      // keep a minus sign out of the fingerprint
+      if (n >= 1 && out[n-1] == '-' && (n == 1 || !IDENT(out[n-2]))) n--;
+      EMIT_LITERAL();
+
+    } else if (isspace((unsigned char)c)) {
+      while (i < len && isspace((unsigned char)str[i]))
+        i++;
+      if (n > 0 && out[n-1] != ' ')
+        out[n++] = ' ';
+
+    } else {
+      out[n++] = c;
+      i++;
+    }
+  }
+
+  #undef IDENT
+  #undef EMIT_LITERAL
+
+  while (n > 0 && out[n-1] == ' ')
+    n--;
+  out[n] = 0;
+  return n;
+}
+
+static int
+agg__free_value(st_data_t key, st_data_t val, st_data_t arg)
+{
+  free((void *)val);
+  return ST_CONTINUE;
+}
+
+static void
+agg__clear()
+{
+  st_foreach(agg.tbl, agg__free_value, 0);
+  st_clear(agg.tbl);
+  agg.generation++;
+}
+
+static agg_stat_t *
+agg__stat(rbtracer_t *tracer, VALUE self)
+{
+  char key[AGG_FINGERPRINT + 32];
+  size_t n = snprintf(key, sizeof(key), "%d", tracer->id);
+  st_data_t stat;
+  int i, tracer_id = tracer->id;
+
+  for (i=0; ; i++) {
+    // evaluating an expression can run a pending command, which may
+    // grow the tracer list or remove this tracer altogether
+    tracer = &rbtracer.list[tracer_id];
+    if (!tracer->query || i >= tracer->num_exprs)
+      break;
+
+    // the raw contents of strings, so their own quotes are not taken out
+    VALUE val = rbtracer__expr(tracer->exprs[i], self, false);
+    if (TYPE(val) != T_STRING)
+      val = rb_inspect(val);
+
+    // only the start of huge values matters
+    long len = RSTRING_LEN(val) < 4 * AGG_FINGERPRINT ? RSTRING_LEN(val) : 4 * AGG_FINGERPRINT;
+    char fp[len+1];
+    agg__fingerprint(RSTRING_PTR(val), len, fp);
+
+    n += snprintf(key + n, sizeof(key) - n, "%s%s", i ? ", " : " ", fp);
+    if (n >= sizeof(key) - 1) {
+      n = sizeof(key) - 1;
+      break;
+    }
+  }
+
+  if (st_lookup(agg.tbl, (st_data_t)key, &stat))
+    return (agg_stat_t *)stat;
+
+  if (agg.tbl->num_entries >= AGG_MAX)
+    return NULL;
+
+  agg_stat_t *s = calloc(1, sizeof(agg_stat_t) + n + 1);
+  if (!s)
+    return NULL;
+
+  s->tracer_id = tracer_id;
+  memcpy(s->fingerprint, key, n + 1);
+  st_insert(agg.tbl, (st_data_t)s->fingerprint, (st_data_t)s);
+  return s;
+}
+
+static void
+agg_hook(bool call, rbtracer_t *tracer, VALUE self)
+{
+  VALUE thread = rb_thread_current();
+  st_data_t data;
+  agg_thread_t *t;
+
+  if (!st_lookup(agg.thread_tbl, (st_data_t)thread, &data)) {
+    if (!call || !(t = calloc(1, sizeof(agg_thread_t))))
+      return;
+    st_insert(agg.thread_tbl, (st_data_t)thread, (st_data_t)t);
+  } else {
+    t = (agg_thread_t *)data;
+  }
+
+  if (call) {
+    agg_stat_t *stat = agg__stat(tracer, self);
+    if (!agg.enabled)
+      return; // a command ran while evaluating, and turned us off
+
+    if (t->depth < AGG_STACK) {
+      t->stack[ t->depth ].stat = stat;
+      t->stack[ t->depth ].generation = agg.generation;
+      t->stack[ t->depth ].start = timeofday_usec();
+    }
+    t->depth++;
+
+  } else if (t->depth > 0) {
+    t->depth--;
+    if (t->depth >= AGG_STACK)
+      return;
+
+    agg_stat_t *stat = t->stack[ t->depth ].stat;
+    if (!stat || t->stack[ t->depth ].generation != agg.generation) {
+      agg.other++;
+      return;
+    }
+
+    uint64_t diff = timeofday_usec() - t->stack[ t->depth ].start;
+    histogram_add(&stat->hist, diff);
+    stat->count++;
+    stat->total += diff;
+    if (diff > stat->max)
+      stat->max = diff;
+  }
+}
+
+static int
+agg__collect(st_data_t key, st_data_t val, st_data_t arg)
+{
+  agg_stat_t ***p = (agg_stat_t ***)arg;
+  if (((agg_stat_t *)val)->count)
+    *(*p)++ = (agg_stat_t *)val;
+  return ST_CONTINUE;
+}
+
+static int
+agg__cmp(const void *a, const void *b)
+{
+  const agg_stat_t *x = *(agg_stat_t **)a, *y = *(agg_stat_t **)b;
+  return x->total < y->total ? 1 : x->total > y->total ? -1 : 0;
+}
+
+// Sends the fingerprints with the most time spent since the last dump, and
+// starts over.
+static void
+agg_dump()
+{
+  if (!agg.enabled)
+    return;
+
+  agg_stat_t **stats = malloc((agg.tbl->num_entries + 1) * sizeof(agg_stat_t *)), **end = stats;
+  unsigned int i, num;
+
+  if (!stats)
+    return;
+
+  st_foreach(agg.tbl, agg__collect, (st_data_t)&end);
+  num = end - stats;
+  qsort(stats, num, sizeof(agg_stat_t *), agg__cmp);
+
+  // waiting for room lets other threads add to the stats, and to the table,
+  // but entries are only freed here or on stop, so each one is sent and
+  // reset in one go once there is room
+  for (i=0; i<num; i++) {
+    agg_stat_t *stat = stats[i];
+
+    if (i < agg.top) {
+      writer_wait(strlen(stat->fingerprint) + 128);
+      rbtrace__send_event(7,
+        "aggstat",
+        'd', stat->tracer_id,
+        's', strchr(stat->fingerprint, ' ') ? strchr(stat->fingerprint, ' ') + 1 : "",
+        'u', stat->count,
+        't', stat->total,
+        't', histogram_quantile(&stat->hist, 0.5),
+        't', histogram_quantile(&stat->hist, 0.99),
+        't', stat->max
+      );
+    }
+
+    stat->count = 0;
+    stat->total = stat->max = 0;
+    memset(&stat->hist, 0, sizeof(histogram_t));
+  }
+  free(stats);
+
+  writer_wait(64);
+  uint64_t usec = timeofday_usec();
+  rbtrace__send_event(3,
+    "aggdone",
+    'u', num,
+    'u', agg.other,
+    't', usec - agg.since
+  );
+
+  // start afresh once full, rather than counting new fingerprints as other
+  if (agg.tbl->num_entries >= AGG_MAX)
+    agg__clear();
+
+  agg.other = 0;
+  agg.since = usec;
+}
+
+static int
+agg__free_thread(st_data_t key, st_data_t val, st_data_t arg)
+{
+  free((void *)val);
+  return ST_CONTINUE;
+}
+
+static void
+agg_stop()
+{
+  if (!agg.enabled)
+    return;
+
+  agg.enabled = false;
+  agg__clear();
+  st_free_table(agg.tbl);
+  agg.tbl = NULL;
+
+  st_foreach(agg.thread_tbl, agg__free_thread, 0);
+  st_free_table(agg.thread_tbl);
+  agg.thread_tbl = NULL;
+}
+
+static void
+agg_start(unsigned int top)
+{
+  agg.top = top;
+  if (agg.enabled)
+    return;
+
+  agg.tbl = st_init_strtable();
+  agg.thread_tbl = st_init_numtable();
+  agg.other = 0;
+  agg.since = timeofday_usec();
+  agg.enabled = true;
+}
+
+// Profile mode times every traced call (every call, with the firehose) and
+// sums them up per method in the process, so a window of activity can be
+// sent as one small record per method and compared against another window.
+#define PROF_MAX 4096 // methods profiled at once
+
+typedef struct {
+  VALUE klass;
+  ID mid;
+  bool singleton;
+  uint64_t count, total, max;
+  double sumsq; // usec^2, for the variance of the mean
+  histogram_t hist;
+} prof_stat_t;
+
+static struct {
+  bool enabled;
+  unsigned int num;
+  uint64_t since;
+  uint64_t other; // calls not counted, with PROF_MAX methods already seen
+  unsigned long serial; // bumped to throw away calls in flight
+
+  // (klass|singleton) -> mid -> prof_stat_t
+  st_table *tbl;
+  st_table *dump; // the window being sent, while calls go to a new one
+}
+prof = {
+  .enabled = false,
+  .num = 0,
+  .since = 0,
+  .other = 0,
+  .serial = 0,
+  .tbl = NULL,
+  .dump = NULL,
+};
+
+static void
+prof_clear()
+{
+  if (prof.tbl) {
+    st_foreach(prof.tbl, adaptive__free_mids, 0);
+    st_clear(prof.tbl);
+  }
+  prof.num = 0;
+  prof.other = 0;
+}
+
+static prof_stat_t *
+prof__lookup(VALUE klass, bool singleton, ID mid)
+{
+  st_data_t key = (st_data_t)klass | singleton;
+  st_data_t mids, stat;
+
+  if (!st_lookup(prof.tbl, key, &mids)) {
+    if (prof.num >= PROF_MAX)
+      return NULL;
+
+    mids = (st_data_t)st_init_numtable();
+    st_insert(prof.tbl, key, mids);
+  }
+
+  if (!st_lookup((st_table *)mids, (st_data_t)mid, &stat)) {
+    if (prof.num >= PROF_MAX)
+      return NULL;
+
+    prof_stat_t *s = calloc(1, sizeof(prof_stat_t));
+    if (!s)
+      return NULL;
+
+    s->klass = klass;
+    s->mid = mid;
+    s->singleton = singleton;
+    st_insert((st_table *)mids, (st_data_t)mid, (st_data_t)s);
+    prof.num++;
+    stat = (st_data_t)s;
+  }
+
+  return (prof_stat_t *)stat;
+}
+
+static void
+prof_hook(rbtrace_local_t *local, bool call, ID mid, VALUE klass, bool singleton)
+{
+  uint64_t usec = timeofday_usec();
+
+  if (local->prof_serial != prof.serial) {
+    local->prof_serial = prof.serial;
+    local->prof_depth = 0;
+  }
+
+  if (call) {
+    if (rbtrace__local_reserve(&local->prof_size, local->prof_depth, &local->prof_times, NULL))
+      local->prof_times[ local->prof_depth ] = usec;
+    local->prof_depth++;
+    return;
+  }
+
+  if (local->prof_depth == 0)
+    return;
+  local->prof_depth--;
+  if (local->prof_depth >= local->prof_size)
+    return;
+
+  uint64_t diff = usec - local->prof_times[ local->prof_depth ];
+  prof_stat_t *stat = prof__lookup(klass, singleton, mid);
+  if (!stat) {
+    prof.other++;
+    return;
+  }
+
+  histogram_add(&stat->hist, diff);
+  stat->count++;
+  stat->total += diff;
+  stat->sumsq += (double)diff * diff;
+  if (diff > stat->max)
+    stat->max = diff;
+}
+
+static int
+prof__send_stat(st_data_t key, st_data_t val, st_data_t arg)
+{
+  prof_stat_t *stat = (prof_stat_t *)val;
+  if (!stat->count)
+    return ST_CONTINUE;
+
+  double mean = (double)stat->total / stat->count,
+         var = stat->sumsq / stat->count - mean * mean;
+
+  // a window is only worth anything whole
+  writer_wait(1024);
+  rbtrace__send_names(stat->mid, stat->klass);
+  rbtrace__send_event(9,
+    "profstat",
+    'l', stat->mid,
+    'b', stat->singleton,
+    'l', stat->klass,
+    't', stat->count,
+    't', stat->total,
+    't', histogram_quantile(&stat->hist, 0.5),
+    't', histogram_quantile(&stat->hist, 0.99),
+    't', stat->max,
+    't', (uint64_t)(var > 0 ? sqrt(var) : 0)
+  );
+  return ST_CONTINUE;
+}
+
+static int
+prof__send_mids(st_data_t key, st_data_t val, st_data_t arg)
+{
+  st_foreach((st_table *)val, prof__send_stat, 0);
+  return ST_CONTINUE;
+}
+
+// Sends what every method did since the last dump, and starts a new window.
+// The old window's table is set aside first, since waiting on the writer
+// lets other threads add calls meanwhile.
+static void
+prof_dump()
+{
+  if (!prof.enabled || prof.dump)
+    return;
+
+  uint64_t usec = timeofday_usec();
+  unsigned int num = prof.num;
+  uint64_t other = prof.other, since = prof.since;
+
+  prof.dump = prof.tbl;
+  prof.tbl = st_init_numtable();
+  prof.num = 0;
+  prof.other = 0;
+  prof.since = usec;
+
+  st_foreach(prof.dump, prof__send_mids, 0);
+
+  writer_wait(64);
+  rbtrace__send_event(3,
+    "profdone",
+    'u', num,
+    't', other,
+    't', usec - since
+  );
+
+  st_foreach(prof.dump, adaptive__free_mids, 0);
+  st_free_table(prof.dump);
+  prof.dump = NULL;
+}
+
+static void
+prof_start()
+{
+  if (!prof.tbl)
+    prof.tbl = st_init_numtable();
+
+  prof_clear();
+  prof.serial++;
+  prof.since = timeofday_usec();
+  prof.enabled = true;
+}
+
+static void
+prof_stop()
+{
+  prof.enabled = false;
+  prof_clear();
+  if (prof.tbl)
+    st_free_table(prof.tbl);
+  prof.tbl = NULL;
+}
+
+#ifdef RBTRACE_WRITER_THREAD
+// Metrics count and time calls to a fixed set of selectors, with or without
+// a client attached, and serve the totals in prometheus' text format on a
+// unix socket. Ruby threads only ever add to the counters, so the native
+// thread serving scrapes never needs the GVL.
+#define METRICS_MAX 1024 // distinct methods counted
+#define METRICS_NAME 256 // bytes of a method's name kept
+
+static const uint64_t metrics_bounds[] = { // usec
+  100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+  100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000
+};
+#define METRICS_BUCKETS (int)(sizeof(metrics_bounds) / sizeof(metrics_bounds[0]))
+
+typedef struct {
+  int selector;
+  char name[METRICS_NAME];
+  uint64_t calls;                        // started
+  uint64_t total;                        // usec, of calls that returned
+  uint64_t buckets[METRICS_BUCKETS + 1]; // the last one is +Inf
+} metrics_stat_t;
+
+static struct {
+  bool enabled;
+  pid_t pid;      // owns the socket
+  bool forked;    // set in the child of a fork, which serves its own socket
+  char *path_template; // socket path, "%p" is replaced with the pid
+  char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+  rbtracer_t *selectors;
+  int num_selectors;
+  unsigned int events; // call events the selectors can match
+
+  metrics_stat_t *stats;
+  uint32_t num_stats;  // published to the server once a stat is set up
+  uint64_t other;      // calls not counted, with stats full
+
+  // (klass|singleton) -> mid -> stat index+1, or 0 for no match
+  st_table *tbl;
+  unsigned long serial; // bumped to reset every thread's stack
+
+  int listen_fd;
+  int fds[2];           // pipe used to stop the server
+  pthread_t thread;
+  bool running;
+}
+metrics = {
+  .enabled = false,
+  .pid = 0,
+  .forked = false,
+  .path_template = NULL,
+  .selectors = NULL,
+  .num_selectors = 0,
+  .events = 0,
+  .stats = NULL,
+  .num_stats = 0,
+  .other = 0,
+  .tbl = NULL,
+  .serial = 0,
+  .listen_fd = -1,
+  .fds = {-1, -1},
+  .running = false
+};
+
+static bool
+  rbtracer__parse(rbtracer_t *tracer, char *query, bool resolve);
+static unsigned int
+  rbtracer__events(rbtracer_t *tracer);
+static void
+  rbtracer__events_refresh(VALUE klass, bool singleton);
+static VALUE
+  rbtracer__lookup(char *name);
+static void
+  rbtracer_pattern_free(rbtracer_pattern_t *pat);
+
+// Selectors are matched by name, so they may name classes that are not
+// loaded yet.
+static bool
+metrics__match(rbtracer_t *sel, const char *klass_name, bool singleton, ID mid, const char *mid_name)
+{
+  if (sel->mid && sel->mid != mid)
+    return false;
+
+  if (sel->is_pattern)
+    return (!sel->klass_pattern.pattern || singleton == sel->is_singleton) &&
+      rbtracer_pattern_match(&sel->klass_pattern, klass_name) &&
+      rbtracer_pattern_match(&sel->mid_pattern, mid_name);
+
+  if (!sel->klass_name)
+    return true;
+
+  return singleton == sel->is_singleton && klass_name &&
+    strlen(klass_name) == sel->klass_len &&
+    0 == strncmp(klass_name, sel->klass_name, sel->klass_len);
+}
+
+// Returns the stat for calls to mid on klass, or NULL if no selector
+// matches it.
+static metrics_stat_t *
+metrics__lookup(VALUE klass, bool singleton, ID mid)
+{
+  st_data_t key = (st_data_t)klass | singleton;
+  st_data_t mids, idx;
+  int i;
+
+  if (!st_lookup(metrics.tbl, key, &mids)) {
+    if (metrics.tbl->num_entries >= MAX_KLASS_CACHE) {
+      st_foreach(metrics.tbl, rbtracer__free_mids, 0);
+      st_clear(metrics.tbl);
+    }
+
+    mids = (st_data_t)st_init_numtable();
+    st_insert(metrics.tbl, key, mids);
+  }
+
+  if (!st_lookup((st_table *)mids, (st_data_t)mid, &idx)) {
+    const char *klass_name = klass ? rb_class2name(klass) : NULL;
+    const char *mid_name = mid ? rb_id2name(mid) : NULL;
+    char name[METRICS_NAME];
+
+    idx = 0;
+    for (i=0; i<metrics.num_selectors; i++) {
+      if (!metrics__match(&metrics.selectors[i], klass_name, singleton, mid, mid_name))
+        continue;
+
+      snprintf(name, sizeof(name), "%s%s%s",
+        klass_name ? klass_name : "",
+        klass_name ? (singleton ? "." : "#") : "",
+        mid_name ? mid_name : "");
+
+      // the cache may have been cleared since this method was first seen
+      uint32_t n;
+      for (n=0; n<metrics.num_stats; n++)
+        if (metrics.stats[n].selector == i && 0 == strcmp(metrics.stats[n].name, name))
+          break;
+
+      if (n == metrics.num_stats && n < METRICS_MAX) {
+        metrics_stat_t *stat = &metrics.stats[n];
+
+        memset(stat, 0, sizeof(*stat));
+        stat->selector = i;
+        strcpy(stat->name, name);
+        __atomic_store_n(&metrics.num_stats, n + 1, __ATOMIC_RELEASE);
+      }
+
+      idx = n < METRICS_MAX ? n + 1 : 0;
+      if (!idx)
+        metrics.other++;
+      break;
+    }
+
+    st_insert((st_table *)mids, (st_data_t)mid, idx);
+  }
+
+  return idx ? &metrics.stats[idx-1] : NULL;
+}
+
+static void
+metrics__restart();
+
+static inline void
+metrics_hook(rbtrace_local_t *local, bool call, ID mid, VALUE klass, bool singleton)
+{
+  if (metrics.forked)
+    metrics__restart();
+
+  if (local->metrics_serial != metrics.serial) {
+    local->metrics_serial = metrics.serial;
+    local->metrics_depth = 0;
+  }
+
+  metrics_stat_t *stat = metrics__lookup(klass, singleton, mid);
+  if (!stat)
+    return;
+
+  uint64_t usec = timeofday_usec();
+  int idx = stat - metrics.stats;
+
+  if (call) {
+    __atomic_add_fetch(&stat->calls, 1, __ATOMIC_RELAXED);
+
+    if (local->metrics_depth < METRICS_STACK) {
+      local->metrics_stack[ local->metrics_depth ].stat = idx;
+      local->metrics_stack[ local->metrics_depth ].start = usec;
+      local->metrics_depth++;
+    }
+
+  } else if (local->metrics_depth > 0 &&
+             local->metrics_stack[ local->metrics_depth-1 ].stat == idx) {
+    // a call is only timed if it was seen starting
+    uint64_t diff = usec - local->metrics_stack[ --local->metrics_depth ].start;
+    int b = 0;
+
+    while (b < METRICS_BUCKETS && diff > metrics_bounds[b])
+      b++;
+
+    __atomic_add_fetch(&stat->buckets[b], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stat->total, diff, __ATOMIC_RELAXED);
+  }
+}
+
+typedef struct {
+  char *ptr;
+  size_t len, size;
+} metrics_buf_t;
+
+#ifdef __GNUC__
+__attribute__((format(printf, 2, 3)))
+#endif
+static void
+metrics__printf(metrics_buf_t *buf, const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+
+  if (!buf->ptr)
+    return;
+
+  for (;;) {
+    va_start(ap, fmt);
+    n = vsnprintf(buf->ptr + buf->len, buf->size - buf->len, fmt, ap);
+    va_end(ap);
+
+    if (n < 0)
+      return;
+    if ((size_t)n < buf->size - buf->len)
+      break;
+
+    char *ptr = realloc(buf->ptr, buf->size * 2 + n);
+    if (!ptr) {
+      free(buf->ptr);
+      buf->ptr = NULL;
+      return;
+    }
+    buf->ptr = ptr;
+    buf->size = buf->size * 2 + n;
+  }
+
+  buf->len += n;
+}
+
+// Writes name as a label value, escaped.
+static void
+metrics__label(metrics_buf_t *buf, const char *name)
+{
+  for (; *name; name++) {
+    if (*name == '\\' || *name == '"')
+      metrics__printf(buf, "\\%c", *name);
+    else if (*name == '\n')
+      metrics__printf(buf, "\\n");
+    else
+      metrics__printf(buf, "%c", *name);
+  }
+}
+
+static void
+metrics__labels(metrics_buf_t *buf, metrics_stat_t *stat)
+{
+  metrics__printf(buf, "method=\"");
+  metrics__label(buf, stat->name);
+  metrics__printf(buf, "\",selector=\"");
+  metrics__label(buf, metrics.selectors[ stat->selector ].query);
+  metrics__printf(buf, "\"");
+}
+
+// Runs on the server thread, without the GVL.
+static void
+metrics__report(metrics_buf_t *buf)
+{
+  uint32_t i, num = __atomic_load_n(&metrics.num_stats, __ATOMIC_ACQUIRE);
+  int b;
+
+  metrics__printf(buf, "# HELP rbtrace_calls_total Calls to methods matching each selector.\n");
+  metrics__printf(buf, "# TYPE rbtrace_calls_total counter\n");
+  for (i=0; i<num; i++) {
+    metrics_stat_t *stat = &metrics.stats[i];
+
+    metrics__printf(buf, "rbtrace_calls_total{");
+    metrics__labels(buf, stat);
+    metrics__printf(buf, "} %" PRIu64 "\n", __atomic_load_n(&stat->calls, __ATOMIC_RELAXED));
+  }
+
+  metrics__printf(buf, "# HELP rbtrace_call_duration_seconds Time spent in calls that returned.\n");
+  metrics__printf(buf, "# TYPE rbtrace_call_duration_seconds histogram\n");
+  for (i=0; i<num; i++) {
+    metrics_stat_t *stat = &metrics.stats[i];
+    uint64_t count = 0;
+
+    for (b=0; b<=METRICS_BUCKETS; b++) {
+      count += __atomic_load_n(&stat->buckets[b], __ATOMIC_RELAXED);
+
+      metrics__printf(buf, "rbtrace_call_duration_seconds_bucket{");
+      metrics__labels(buf, stat);
+      if (b < METRICS_BUCKETS)
+        metrics__printf(buf, ",le=\"%g\"} %" PRIu64 "\n", metrics_bounds[b] / 1e6, count);
+      else
+        metrics__printf(buf, ",le=\"+Inf\"} %" PRIu64 "\n", count);
+    }
+
+    metrics__printf(buf, "rbtrace_call_duration_seconds_sum{");
+    metrics__labels(buf, stat);
+    metrics__printf(buf, "} %.6f\n", __atomic_load_n(&stat->total, __ATOMIC_RELAXED) / 1e6);
+
+    metrics__printf(buf, "rbtrace_call_duration_seconds_count{");
+    metrics__labels(buf, stat);
+    metrics__printf(buf, "} %" PRIu64 "\n", count);
+  }
+
+  metrics__printf(buf, "# HELP rbtrace_calls_uncounted_total Calls to methods seen after too many others.\n");
+  metrics__printf(buf, "# TYPE rbtrace_calls_uncounted_total counter\n");
+  metrics__printf(buf, "rbtrace_calls_uncounted_total %" PRIu64 "\n", __atomic_load_n(&metrics.other, __ATOMIC_RELAXED));
+}
+
+// Answers one scrape, over http if it looks like one and as plain text
+// otherwise.
+static void
+metrics__serve(int fd)
+{
+  struct pollfd pfd = {.fd = fd, .events = POLLIN};
+  struct timeval timeout = {.tv_sec = 1, .tv_usec = 0};
+  metrics_buf_t buf = {malloc(16384), 0, 16384};
+  char req[1024];
+  ssize_t n = 0;
+
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  if (poll(&pfd, 1, 100) == 1)
+    n = read(fd, req, sizeof(req));
+
+  if (n >= 4 && 0 == memcmp(req, "GET ", 4))
+    metrics__printf(&buf, "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nConnection: close\r\n\r\n");
+
+  metrics__report(&buf);
+
+  size_t off = 0;
+  while (buf.ptr && off < buf.len) {
+    ssize_t sent = write(fd, buf.ptr + off, buf.len - off);
+    if (sent <= 0 && errno != EINTR)
+      break;
+    if (sent > 0)
+      off += sent;
+  }
+
+  free(buf.ptr);
+}
+
+static void *
+metrics_thread(void *data)
+{
+  struct pollfd pfds[2] = {
+    {.fd = metrics.listen_fd, .events = POLLIN},
+    {.fd = metrics.fds[0], .events = POLLIN}
+  };
+
+  for (;;) {
+    if (poll(pfds, 2, -1) == -1) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    if (pfds[1].revents)
+      break;
+
+    if (pfds[0].revents & POLLIN) {
+      int fd = accept(metrics.listen_fd, NULL, NULL);
+      if (fd != -1) {
+        metrics__serve(fd);
+        close(fd);
+      }
+    }
+  }
+
+  return NULL;
+}
+
+// Stops the server, if this process runs it.
+static void
+metrics__close()
+{
+  if (metrics.running && metrics.pid == getpid()) {
+    if (write(metrics.fds[1], "", 1) == 1)
+      pthread_join(metrics.thread, NULL);
+    unlink(metrics.path);
+  }
+  metrics.running = false;
+
+  if (metrics.listen_fd != -1)
+    close(metrics.listen_fd);
+  if (metrics.fds[0] != -1) {
+    close(metrics.fds[0]);
+    close(metrics.fds[1]);
+  }
+  metrics.listen_fd = metrics.fds[0] = metrics.fds[1] = -1;
+}
+
+// Starts serving on the socket for this process. Returns false with errno
+// set if it could not.
+static bool
+metrics__listen()
+{
+  struct sockaddr_un addr = {.sun_family = AF_UNIX};
+  size_t len = 0;
+  const char *p;
+  sigset_t all, old;
+  int err;
+
+  for (p = metrics.path_template; *p && len < sizeof(metrics.path) - 1; p++) {
+    if (p[0] == '%' && p[1] == 'p') {
+      len += snprintf(metrics.path + len, sizeof(metrics.path) - len, "%d", (int)getpid());
+      p++;
+    } else {
+      metrics.path[len++] = *p;
+    }
+  }
+  if (*p || len >= sizeof(metrics.path) - 1) {
+    errno = ENAMETOOLONG;
+    return false;
+  }
+  metrics.path[len] = 0;
+  strcpy(addr.sun_path, metrics.path);
+
+  metrics.pid = getpid();
+  metrics.forked = false;
+  unlink(metrics.path);
+
+  if ((metrics.listen_fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1 ||
+      fcntl(metrics.listen_fd, F_SETFD, FD_CLOEXEC) == -1 ||
+      bind(metrics.listen_fd, (struct sockaddr *)&addr, SUN_LEN(&addr)) == -1 ||
+      chmod(metrics.path, 0600) == -1 ||
+      listen(metrics.listen_fd, 16) == -1 ||
+      pipe(metrics.fds) == -1)
+    goto fail;
+
+  fcntl(metrics.fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(metrics.fds[1], F_SETFD, FD_CLOEXEC);
+
+  // signals are for ruby threads to handle
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+  err = pthread_create(&metrics.thread, NULL, metrics_thread, NULL);
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+  if (err) {
+    errno = err;
+    goto fail;
+  }
+
+  metrics.running = true;
+  return true;
+
+fail:
+  err = errno;
+  metrics__close();
+  unlink(metrics.path);
+  errno = err;
+  return false;
+}
+
+static void
+metrics__atfork_child()
+{
+  if (metrics.enabled)
+    metrics.forked = true;
+}
+
+static void
+metrics__end_proc(VALUE data)
+{
+  if (metrics.running && metrics.pid == getpid())
+    unlink(metrics.path);
+}
+
+// In the child of a fork: the server did not survive it, and the counts so
+// far are the parent's.
+static void
+metrics__restart()
+{
+  uint32_t i;
+
+  metrics.forked = false;
+  metrics__close();
+
+  for (i=0; i<metrics.num_stats; i++) {
+    metrics.stats[i].calls = metrics.stats[i].total = 0;
+    memset(metrics.stats[i].buckets, 0, sizeof(metrics.stats[i].buckets));
+  }
+  metrics.other = 0;
+  metrics.serial++;
+
+  if (!metrics__listen())
+    fprintf(stderr, "rbtrace: could not serve metrics on %s: %s\n", metrics.path, strerror(errno));
+}
+
+// Which call events a selector can match: see rbtracer__events(), but
+// looking its class up by name.
+static unsigned int
+metrics__events(rbtracer_t *sel)
+{
+  if (sel->is_pattern || !sel->mid || !sel->klass_name)
+    return RBTRACE_EVENTS_ALL;
+
+  char *name = strndup(sel->klass_name, sel->klass_len);
+  VALUE klass = rbtracer__lookup(name);
+  free(name);
+
+  if (!klass)
+    return RBTRACE_EVENTS_ALL;
+
+  rbtracer_t tracer = *sel;
+  tracer.klass = sel->is_singleton ? 0 : klass;
+  tracer.self = sel->is_singleton ? klass : 0;
+
+  return rbtracer__events(&tracer);
+}
+
+static void
+metrics__events_refresh()
+{
+  int i;
+
+  if (!metrics.enabled)
+    return;
+
+  metrics.events = 0;
+  for (i=0; i<metrics.num_selectors; i++)
+    metrics.events |= metrics__events(&metrics.selectors[i]);
+}
+
+// Returns true if a selector names a single method of klass (or of self,
+// for singleton methods), so its methods being redefined may change the
+// call events to listen to. Any class at all when klass is 0.
+static bool
+metrics__names(VALUE klass, bool singleton)
+{
+  const char *name = NULL;
+  int i;
+
+  for (i=0; metrics.enabled && i<metrics.num_selectors; i++) {
+    rbtracer_t *sel = &metrics.selectors[i];
+    if (sel->is_pattern || !sel->mid || !sel->klass_name)
+      continue;
+    if (!klass)
+      return true;
+    if (sel->is_singleton != singleton)
+      continue;
+
+    if (!name)
+      name = rb_class2name(klass);
+    if (name && strlen(name) == sel->klass_len &&
+        0 == strncmp(name, sel->klass_name, sel->klass_len))
+      return true;
+  }
+
+  return false;
+}
+
+static void
+  event_hook_update();
+
+static void
+metrics_stop()
+{
+  int i;
+
+  if (!metrics.enabled)
+    return;
+
+  metrics.enabled = false;
+  metrics__close();
+
+  for (i=0; i<metrics.num_selectors; i++) {
+    rbtracer_pattern_free(&metrics.selectors[i].klass_pattern);
+    rbtracer_pattern_free(&metrics.selectors[i].mid_pattern);
+    free(metrics.selectors[i].query);
+  }
+  free(metrics.selectors);
+  metrics.selectors = NULL;
+  metrics.num_selectors = 0;
+
+  st_foreach(metrics.tbl, rbtracer__free_mids, 0);
+  st_free_table(metrics.tbl);
+  metrics.tbl = NULL;
+
+  free(metrics.stats);
+  metrics.stats = NULL;
+  metrics.num_stats = 0;
+  metrics.other = 0;
+  metrics.serial++;
+
+  free(metrics.path_template);
+  metrics.path_template = NULL;
+
+  event_hook_update();
+}
+
+static VALUE
+metrics_stop_m(VALUE mod)
+{
+  metrics_stop();
+  return Qnil;
+}
+
+// Counts calls to selectors from now on, and serves them on the socket at
+// path. Returns the path, with the pid filled in.
+static VALUE
+metrics_start_m(VALUE mod, VALUE path, VALUE selectors)
+{
+  static bool registered = false;
+  long i;
+
+  Check_Type(selectors, T_ARRAY);
+  StringValue(path);
+  for (i=0; i<RARRAY_LEN(selectors); i++)
+    StringValue(RARRAY_PTR(selectors)[i]);
+
+  metrics_stop();
+
+  metrics.selectors = calloc(RARRAY_LEN(selectors) + 1, sizeof(rbtracer_t));
+  metrics.stats = calloc(METRICS_MAX, sizeof(metrics_stat_t));
+  metrics.path_template = strndup(RSTRING_PTR(path), RSTRING_LEN(path));
+  metrics.tbl = st_init_numtable();
+  metrics.events = 0;
+  metrics.enabled = true;
+
+  if (!metrics.selectors || !metrics.stats || !metrics.path_template) {
+    metrics_stop();
+    rb_raise(rb_eNoMemError, "failed to allocate memory for metrics");
+  }
+
+  for (i=0; i<RARRAY_LEN(selectors); i++) {
+    char *query = strndup(RSTRING_PTR(RARRAY_PTR(selectors)[i]), RSTRING_LEN(RARRAY_PTR(selectors)[i]));
+    rbtracer_t *sel = &metrics.selectors[ metrics.num_selectors ];
+    bool valid = rbtracer__parse(sel, query, false);
+
+    free(query);
+    if (!valid) {
+      metrics_stop();
+      rb_raise(rb_eArgError, "invalid selector: %s", StringValueCStr(RARRAY_PTR(selectors)[i]));
+    }
+
+    metrics.num_selectors++;
+    metrics.events |= metrics__events(sel);
+  }
+
+  if (!registered) {
+    pthread_atfork(NULL, NULL, metrics__atfork_child);
+    rb_set_end_proc(metrics__end_proc, 0);
+    registered = true;
+  }
+
+  if (!metrics__listen()) {
+    int err = errno;
+    VALUE failed = rb_str_new_cstr(metrics.path);
+
+    metrics_stop();
+    errno = err;
+    rb_sys_fail_str(failed);
+  }
+
+  event_hook_update();
+  return rb_str_new_cstr(metrics.path);
+}
+#else
+static struct {
+  bool enabled;
+  unsigned int events;
+  st_table *tbl;
+} metrics = {
+  .enabled = false,
+  .events = 0,
+  .tbl = NULL
+};
+
+static void
+metrics_hook(rbtrace_local_t *local, bool call, ID mid, VALUE klass, bool singleton)
+{
+}
+
+static void
+metrics__events_refresh()
+{
+}
+
+static bool
+metrics__names(VALUE klass, bool singleton)
+{
+  return false;
+}
+
+static VALUE
+metrics_stop_m(VALUE mod)
+{
+  return Qnil;
+}
+
+static VALUE
+metrics_start_m(VALUE mod, VALUE path, VALUE selectors)
+{
+  rb_raise(rb_eNotImpError, "metrics need pthreads");
+}
+#endif
+
+// event_hook__run() is compiled once for each combination of modes below,
+// and event_hook_update() installs the one for what is being traced. Checks
+// for modes a hook is not compiled for are constant, and drop out.
+#define HOOK_FIREHOSE 0x1 // trace every call
+#define HOOK_METHODS  0x2 // trace calls matching a tracer
+#define HOOK_SLOW     0x4 // only report slow calls
+#define HOOK_EXTRAS   0x8 // recorder, tail, gvl, io, aggregate, profile, adaptive, devmode
+#define HOOK_ALL      (HOOK_FIREHOSE | HOOK_METHODS | HOOK_SLOW | HOOK_EXTRAS)
+
+#ifdef __GNUC__
+#define RBTRACE_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define RBTRACE_ALWAYS_INLINE inline
+#endif
+
+static RBTRACE_ALWAYS_INLINE void
+event_hook__run(const int mode, unsigned int event, VALUE self, ID mid, VALUE klass)
+{
+  rbtrace_local_t *local = rbtrace_local();
+
+  // do not re-enter this function
+  // after this, must `goto out` instead of `return`
+  if (!local || local->in_event_hook) return;
+  local->in_event_hook++;
+
+#ifdef ID_ALLOCATOR
+  // skip allocators
+  if (mid == ID_ALLOCATOR) goto out;
+#endif
+
+#ifdef RUBY_VM
+  if (mid == 0) {
+    ID _mid;
+    VALUE _klass;
+    rb_frame_method_id_and_class(&_mid, &_klass);
+
+    mid = _mid;
+    klass = _klass;
+  }
+#endif
+
+  // normalize klass and check for class-level methods
+  bool singleton = false;
+  if (klass) {
+    if (TYPE(klass) == T_ICLASS) {
+      klass = RBASIC_CLASS(klass);
+    }
+
+    singleton = FL_TEST(klass, FL_SINGLETON);
+
+#ifdef RUBY_VM
+    if (singleton &&
+        !(TYPE(self) == T_CLASS ||
+          TYPE(self) == T_MODULE))
+      singleton = false;
+#endif
+  }
+
+  if ((mode & HOOK_EXTRAS) && recorder.enabled) {
+    recorder_hook(local,
+      event == RUBY_EVENT_CALL || event == RUBY_EVENT_C_CALL,
+      event == RUBY_EVENT_C_CALL || event == RUBY_EVENT_C_RETURN,
+      mid, singleton ? self : klass, singleton
+    );
+  }
+
+  if ((mode & HOOK_EXTRAS) && metrics.enabled) {
+    metrics_hook(local,
+      event == RUBY_EVENT_CALL || event == RUBY_EVENT_C_CALL,
+      mid, singleton ? self : klass, singleton
+    );
+  }
+
+  // the recorder and metrics keep going without a client
+  if ((mode & HOOK_EXTRAS) && !rbtracer.attached_pid)
+    goto out;
+
+  if ((mode & HOOK_EXTRAS) && tail.enabled) {
+    tail_hook(local,
+      event == RUBY_EVENT_CALL || event == RUBY_EVENT_C_CALL,
+      event == RUBY_EVENT_C_CALL || event == RUBY_EVENT_C_RETURN,
+      mid, klass, self, singleton
+    );
+    goto out;
+  }
+
+  if ((mode & HOOK_EXTRAS) && gvl.enabled) {
+    gvl_hook(event == RUBY_EVENT_CALL || event == RUBY_EVENT_C_CALL, mid, klass, self, singleton);
+    goto out;
+  }
+
+  if ((mode & HOOK_EXTRAS) && io.enabled) {
+    if (event == RUBY_EVENT_C_CALL || event == RUBY_EVENT_C_RETURN)
+      io_hook(event == RUBY_EVENT_C_CALL, mid, self, singleton);
+    goto out;
+  }
+
+  if ((mode & HOOK_EXTRAS) && rbtracer.devmode)
+    rbtracer_devmode_sync();
+
+  rbtracer_t *tracer = NULL;
+
+  if ((mode & HOOK_FIREHOSE) && rbtracer.firehose) {
+    // trace everything
+
+  } else if ((mode & HOOK_METHODS) && rbtracer.num > 0) {
+    // tracing only specific methods
+    tracer = rbtracer_match(mid, klass, self, singleton);
+
+    if (tracer) {
+      // matched something, all good!
+    } else if ((mode & HOOK_SLOW) && rbtracer.slow && rbtracer.num_slow == 0) {
+      // in global slow mode, so go ahead.
+    } else {
+      goto out;
+    }
+
+  } else if ((mode & HOOK_SLOW) && rbtracer.slow && rbtracer.num_slow == 0) {
+    // trace everything that's slow
+
+  } else {
     // what are we doing here?
     goto out;
   }
 
-  // are we watching for slow method calls?
-  if (rbtracer.slow && (!tracer || tracer->is_slow)) {
-    uint64_t usec = timeofday_usec(),
-             ut_usec = ru_utime_usec(),
-             diff = 0;
-
-    switch (event) {
-      case RUBY_EVENT_C_CALL:
-      case RUBY_EVENT_CALL:
-        if (rbtracer.num_calls < MAX_CALLS) {
-          rbtracer.call_times[ rbtracer.num_calls ] = usec;
-          if (rbtracer.slowcpu)
-            rbtracer.call_utimes[ rbtracer.num_calls ] = ut_usec;
-        }
+  if ((mode & HOOK_EXTRAS) && agg.enabled) {
+    if (tracer)
+      agg_hook(event == RUBY_EVENT_CALL || event == RUBY_EVENT_C_CALL, tracer, self);
+    goto out;
+  }
 
-        rbtracer.num_calls++;
-        break;
+  if ((mode & HOOK_EXTRAS) && prof.enabled) {
+    prof_hook(local, event == RUBY_EVENT_CALL || event == RUBY_EVENT_C_CALL, mid, singleton ? self : klass, singleton);
+    goto out;
+  }
 
-      case RUBY_EVENT_C_RETURN:
-      case RUBY_EVENT_RETURN:
-        if (rbtracer.num_calls > 0) {
-          rbtracer.num_calls--;
+  // are we watching for slow method calls?
+  if ((mode & HOOK_SLOW) && rbtracer.slow && (!tracer || tracer->is_slow)) {
+    uint64_t wall = 0, cpu = 0;
+
+    rbtrace__local_time(local,
+      event == RUBY_EVENT_CALL || event == RUBY_EVENT_C_CALL,
+      timeofday_usec(),
+      rbtracer.slowcpu || rbtracer.cputime ? cputime_usec() : 0,
+      &wall, &cpu
+    );
 
-          if (rbtracer.num_calls < MAX_CALLS) {
-            if (rbtracer.slowcpu)
-              diff = ut_usec - rbtracer.call_utimes[ rbtracer.num_calls ];
-            else
-              diff = usec - rbtracer.call_times[ rbtracer.num_calls ];
-          }
-        }
-        break;
+    uint64_t diff = rbtracer.slowcpu ? cpu : wall;
+
+    // the global threshold is a floor for per-method ones
+    uint64_t threshold = rbtracer.threshold * 1000;
+    if ((mode & HOOK_EXTRAS) && adaptive.enabled && (event == RUBY_EVENT_RETURN || event == RUBY_EVENT_C_RETURN)) {
+      uint64_t expected = adaptive_sample(singleton ? self : klass, singleton, mid, diff);
+      if (!expected)
+        goto out;
+      if (expected > threshold)
+        threshold = expected;
     }
 
-    if (diff > rbtracer.threshold * 1e3) {
+    if (diff > threshold) {
       rbtrace__send_names(mid, singleton ? self : klass);
-      rbtrace__send_event(6,
+      int stack_id = rbtrace__send_stack();
+
+      // in cputime mode, calls are reported with their wall time either way
+      rbtrace__send_event(rbtracer.threads ? 10 : rbtracer.cputime ? 9 : 8,
         event == RUBY_EVENT_RETURN ? "slow" : "cslow",
-        't', rbtracer.call_times[ rbtracer.num_calls ],
-        't', diff,
-        'u', rbtracer.num_calls,
+        't', local->call_times[ local->num_calls ],
+        't', rbtracer.cputime ? wall : diff,
+        'u', local->num_calls,
         'l', mid,
         'b', singleton,
-        'l', singleton ? self : klass
+        'l', singleton ? self : klass,
+        'd', stack_id,
+        't', (mode & HOOK_EXTRAS) && adaptive.enabled ? threshold : 0,
+        't', cpu,
+        'l', rb_thread_current()
       );
     }
 
     goto out;
   }
 
+  uint64_t wall = 0, cpu = 0;
+  if (rbtracer.cputime)
+    rbtrace__local_time(local,
+      event == RUBY_EVENT_CALL || event == RUBY_EVENT_C_CALL,
+      timeofday_usec(), cputime_usec(),
+      &wall, &cpu
+    );
+
   switch (event) {
     case RUBY_EVENT_CALL:
     case RUBY_EVENT_C_CALL:
       rbtrace__send_names(mid, singleton ? self : klass);
-      rbtrace__send_event(5,
+      rbtrace__send_event(rbtracer.threads ? 6 : 5,
         event == RUBY_EVENT_CALL ? "call" : "ccall",
         'n',
-        'd', tracer ? tracer->id : 255, // hax
+        'd', tracer ? tracer->id : -1,
         'l', mid,
         'b', singleton,
-        'l', singleton ? self : klass
+        'l', singleton ? self : klass,
+        'l', rb_thread_current()
       );
 
-      if (tracer && tracer->num_exprs) {
-        int i;
-        for (i=0; i<tracer->num_exprs; i++) {
-          char *expr = tracer->exprs[i];
-          size_t len = strlen(expr);
+      if (tracer && tracer->num_exprs && rbtracer__expr_allowed(tracer)) {
+        int i, tracer_id = tracer->id;
+        for (i=0; ; i++) {
+          // evaluating an expression can run a pending command, which may
+          // grow the tracer list or remove this tracer altogether
+          tracer = &rbtracer.list[tracer_id];
+          if (!tracer->query || i >= tracer->num_exprs)
+            break;
 
-          VALUE val = Qnil;
-          char buffer[len+150];
+          VALUE val = rbtracer__expr(tracer->exprs[i], self, true);
           char *result = NULL;
 
-          if (len == 4 && strcmp("self", expr) == 0) {
-            val = rb_inspect(self);
+          if (RTEST(val) && TYPE(val) == T_STRING) {
+            result = RSTRING_PTR(val);
+          }
+
+          if (result && *result) {
+            rbtrace__send_event(3,
+              "exprval",
+              'd', tracer_id,
+              'd', i,
+              's', result
+            );
+          }
+        }
+      }
+      break;
+
+    case RUBY_EVENT_RETURN:
+    case RUBY_EVENT_C_RETURN:
+      rbtrace__send_event(rbtracer.threads ? 4 : rbtracer.cputime ? 3 : 2,
+        event == RUBY_EVENT_RETURN ? "return" : "creturn",
+        'n',
+        'd', tracer ? tracer->id : -1,
+        't', cpu,
+        'l', rb_thread_current()
+      );
+      break;
+  }
+
+out:
+  local->in_event_hook--;
+}
 
-          } else if (len == 10 && strcmp("__source__", expr) == 0) {
-            snprintf(buffer, len+150, "\"%s:%d\"", rb_sourcefile(), rb_sourceline());
-            result = buffer;
+#ifdef RUBY_VM
+#define EVENT_HOOK(name, mode) \
+  static void \
+  name(rb_event_flag_t event, VALUE data, VALUE self, ID mid, VALUE klass) \
+  { event_hook__run(mode, event, self, mid, klass); }
+#else
+#define EVENT_HOOK(name, mode) \
+  static void \
+  name(rb_event_t event, NODE *node, VALUE self, ID mid, VALUE klass) \
+  { event_hook__run(mode, event, self, mid, klass); }
+#endif
 
-          } else if (len > 2 && expr[0] == '@' && expr[1] != '@') {
-            val = rb_inspect(rb_ivar_get(self, rb_intern(expr)));
+EVENT_HOOK(event_hook, HOOK_ALL)
+EVENT_HOOK(event_hook_firehose, HOOK_FIREHOSE)
+EVENT_HOOK(event_hook_methods, HOOK_METHODS)
+EVENT_HOOK(event_hook_slow, HOOK_FIREHOSE | HOOK_METHODS | HOOK_SLOW)
 
-          } else {
-            snprintf(buffer, len+150, "(begin; ObjectSpace._id2ref(%ld).instance_eval{ %s }; rescue Exception => e; e; end).inspect", NUM2LONG(rb_obj_id(self)), expr);
-            val = rb_eval_string_protect(buffer, 0);
-          }
+static void
+#ifdef RUBY_VM
+devmode_class_hook(rb_event_flag_t event, VALUE data, VALUE self, ID mid, VALUE klass)
+#else
+devmode_class_hook(rb_event_t event, NODE *node, VALUE self, ID mid, VALUE klass)
+#endif
+{
+  rbtracer.devmode_serial++;
+}
+
+static void
+devmode_install()
+{
+  if (!rbtracer.devmode) {
+    rb_add_event_hook(
+      devmode_class_hook,
+      RUBY_EVENT_CLASS
+#ifdef RUBY_VM
+      , 0
+#endif
+    );
+    rbtracer.devmode = true;
+  }
+}
 
-          if (RTEST(val) && TYPE(val) == T_STRING) {
-            result = RSTRING_PTR(val);
-          }
+static void
+devmode_remove()
+{
+  if (rbtracer.devmode) {
+    rb_remove_event_hook(devmode_class_hook);
+    rbtracer.devmode = false;
+  }
+}
 
-          if (result && *result) {
-            rbtrace__send_event(3,
-              "exprval",
-              'd', tracer->id,
-              'd', i,
-              's', result
-            );
-          }
-        }
-      }
-      break;
+// Methods named by a tracer are narrowed to the one kind of call event they
+// fire, so they must be looked at again when they are redefined, maybe as
+// another kind. Ruby tells classes through method_added and
+// singleton_method_added, which run as cfuncs unless the class defines its
+// own in ruby. Only the class is known here, not which method it gained.
+static ID id_method_added, id_singleton_method_added;
+static bool method_watch_installed = false;
 
-    case RUBY_EVENT_RETURN:
-    case RUBY_EVENT_C_RETURN:
-      rbtrace__send_event(2,
-        event == RUBY_EVENT_RETURN ? "return" : "creturn",
-        'n',
-        'd', tracer ? tracer->id : 255 // hax
-      );
-      break;
-  }
+static void
+#ifdef RUBY_VM
+method_watch_hook(rb_event_flag_t event, VALUE data, VALUE self, ID mid, VALUE klass)
+#else
+method_watch_hook(rb_event_t event, NODE *node, VALUE self, ID mid, VALUE klass)
+#endif
+{
+#ifdef RUBY_VM
+  if (mid == 0)
+    rb_frame_method_id_and_class(&mid, &klass);
+#endif
 
-out:
-  in_event_hook--;
+  if (mid == id_method_added)
+    rbtracer__events_refresh(self, false);
+  else if (mid == id_singleton_method_added)
+    rbtracer__events_refresh(self, true);
 }
 
 static void
-event_hook_install()
+method_watch_update()
 {
-  if (!rbtracer.installed) {
+  bool watch = rbtracer.num_watched || metrics__names(0, false);
+
+  if (watch == method_watch_installed)
+    return;
+
+  if (watch)
     rb_add_event_hook(
-      event_hook,
-      RUBY_EVENT_CALL   | RUBY_EVENT_C_CALL |
-      RUBY_EVENT_RETURN | RUBY_EVENT_C_RETURN
+      method_watch_hook,
+      RUBY_EVENT_CALL | RUBY_EVENT_C_CALL
 #ifdef RUBY_VM
       , 0
 #endif
     );
-    rbtracer.installed = true;
-  }
+  else
+    rb_remove_event_hook(method_watch_hook);
+
+  method_watch_installed = watch;
 }
 
+// Installs the hook specialized for the current modes, listening only to the
+// events something can match, or removes it when nothing is being traced.
+// Called whenever the modes or tracers change.
 static void
-event_hook_remove()
+event_hook_update()
 {
-  if (rbtracer.installed) {
-    rb_remove_event_hook(event_hook);
-    rbtracer.installed = false;
-  }
+  rb_event_hook_func_t hook = NULL;
+  unsigned int events = 0;
+
+  method_watch_update();
+
+  if (recorder.enabled || tail.enabled || rbtracer.firehose ||
+      (rbtracer.slow && rbtracer.num_slow == 0))
+    events = RBTRACE_EVENTS_ALL;
+  if (io.enabled)
+    events |= RBTRACE_EVENTS_CFUNC;
+  if (metrics.enabled)
+    events |= metrics.events;
+  if (rbtracer.num_ruby_events)
+    events |= RBTRACE_EVENTS_RUBY;
+  if (rbtracer.num_cfunc_events)
+    events |= RBTRACE_EVENTS_CFUNC;
+
+  if (!events)
+    hook = NULL;
+  else if (recorder.enabled || metrics.enabled || tail.enabled || gvl.enabled ||
+           io.enabled || agg.enabled || prof.enabled || adaptive.enabled || rbtracer.devmode)
+    hook = event_hook;
+  else if (rbtracer.slow)
+    hook = event_hook_slow;
+  else if (rbtracer.firehose)
+    hook = event_hook_firehose;
+  else
+    hook = event_hook_methods;
+
+  if (hook == rbtracer.hook && events == rbtracer.hook_events)
+    return;
+
+  if (rbtracer.hook)
+    rb_remove_event_hook(rbtracer.hook);
+
+  if (hook)
+    rb_add_event_hook(hook, events
+#ifdef RUBY_VM
+      , 0
+#endif
+    );
+
+  rbtracer.hook = hook;
+  rbtracer.hook_events = events;
+
+  // calls already under way may not have been seen, or will not return
+  rbtracer.calls_serial++;
 }
 
 #ifdef HAVE_RB_GC_ADD_EVENT_HOOK
@@ -573,6 +4706,39 @@ rbtrace_gc_event_hook(rb_gc_event_t gc_event, VALUE obj)
 }
 #endif
 
+static bool
+rbtracer_pattern_init(rbtracer_pattern_t *pat, const char *str, size_t len)
+{
+  memset(pat, 0, sizeof(*pat));
+  if (len == 0)
+    return true;
+
+  if (len > 2 && str[0] == '/' && str[len-1] == '/') {
+    pat->pattern = strndup(str+1, len-2);
+    pat->is_regex = true;
+
+    if (0 != regcomp(&pat->regex, pat->pattern, REG_EXTENDED|REG_NOSUB)) {
+      free(pat->pattern);
+      pat->pattern = NULL;
+      pat->is_regex = false;
+      return false;
+    }
+  } else {
+    pat->pattern = strndup(str, len);
+  }
+
+  return true;
+}
+
+static void
+rbtracer_pattern_free(rbtracer_pattern_t *pat)
+{
+  if (pat->is_regex)
+    regfree(&pat->regex);
+  free(pat->pattern);
+  memset(pat, 0, sizeof(*pat));
+}
+
 static int
 rbtracer_remove(char *query, int id)
 {
@@ -581,7 +4747,7 @@ rbtracer_remove(char *query, int id)
   rbtracer_t *tracer = NULL;
 
   if (query) {
-    for (i=0; i<MAX_TRACERS; i++) {
+    for (i=0; i<(int)rbtracer.list_size; i++) {
       if (rbtracer.list[i].query) {
         if (0 == strcmp(query, rbtracer.list[i].query)) {
           tracer = &rbtracer.list[i];
@@ -590,31 +4756,49 @@ rbtracer_remove(char *query, int id)
       }
     }
   } else {
-    if (id >= MAX_TRACERS) goto out;
+    if (id < 0 || id >= (int)rbtracer.list_size) goto out;
     tracer = &rbtracer.list[id];
   }
 
-  if (tracer->query) {
+  if (tracer && tracer->query) {
     tracer_id = tracer->id;
+    if (!tracer->is_pattern && tracer->mid && (tracer->klass || tracer->self))
+      rbtracer.num_watched--;
     tracer->mid = 0;
 
     free(tracer->query);
     tracer->query = NULL;
 
+    if (tracer->klass_cache) {
+      st_free_table(tracer->klass_cache);
+      tracer->klass_cache = NULL;
+    }
+
+    if (tracer->is_pattern) {
+      rbtracer_pattern_free(&tracer->klass_pattern);
+      rbtracer_pattern_free(&tracer->mid_pattern);
+      tracer->is_pattern = false;
+      rbtracer.num_patterns--;
+      rbtracer_patterns_clear();
+    }
+
     if (tracer->num_exprs) {
       for(i=0; i<tracer->num_exprs; i++) {
         free(tracer->exprs[i]);
-        tracer->exprs[i] = NULL;
       }
       tracer->num_exprs = 0;
     }
+    free(tracer->exprs);
+    tracer->exprs = NULL;
 
     rbtracer.num--;
     if (tracer->is_slow)
       rbtracer.num_slow--;
-
-    if (rbtracer.num == 0)
-      event_hook_remove();
+    if (tracer->events & RBTRACE_EVENTS_RUBY)
+      rbtracer.num_ruby_events--;
+    if (tracer->events & RBTRACE_EVENTS_CFUNC)
+      rbtracer.num_cfunc_events--;
+    tracer->events = 0;
   }
 
 out:
@@ -634,12 +4818,22 @@ rbtracer_detach()
   rbtracer.firehose = false;
   rbtracer.slow = false;
   rbtracer.slowcpu = false;
+  rbtracer.cputime = false;
+  rbtracer.threads = false;
   rbtracer.gc = false;
-  rbtracer.devmode = false;
-  rbtracer.num_calls = 0;
-
-  int i;
-  for (i=0; i<MAX_TRACERS; i++) {
+  rbtracer.calls_serial++;
+  rbtracer.expr_max_len = rbtracer.expr_max_rate = rbtracer.expr_sample = 0;
+  devmode_remove();
+  tail_stop();
+  adaptive_stop();
+  gvl_stop();
+  io_stop();
+  agg_stop();
+  prof_stop();
+  wakeup_stop();
+
+  unsigned int i;
+  for (i=0; i<rbtracer.list_size; i++) {
     if (rbtracer.list[i].query) {
       rbtracer_remove(NULL, i);
     }
@@ -653,35 +4847,202 @@ rbtracer_detach()
     st_free_table(rbtracer.klass_tbl);
   rbtracer.klass_tbl = NULL;
 
-  event_hook_remove();
+  rbtracer_patterns_clear();
+  if (rbtracer.pattern_tbl)
+    st_free_table(rbtracer.pattern_tbl);
+  rbtracer.pattern_tbl = NULL;
+
+  rbtrace__stacks_clear();
+  if (rbtracer.stack_tbl)
+    st_free_table(rbtracer.stack_tbl);
+  rbtracer.stack_tbl = NULL;
+  rbtracer.next_stack_id = 0;
+
+  // the flight recorder keeps going without a client
+  event_hook_update();
 #ifdef HAVE_RB_GC_ADD_EVENT_HOOK
   rb_gc_remove_event_hook(rbtrace_gc_event_hook);
 #endif
 }
 
-static int
-rbtracer_add(char *query, bool is_slow)
+// Find the character splitting a selector into its class and method parts.
+// Regexes are delimited by slashes and may contain '.' or '#' themselves.
+static char *
+rbtracer__find_separator(char *query)
 {
-  int i;
-  int tracer_id = -1;
-  rbtracer_t *tracer = NULL;
+  char *p;
 
-  if (rbtracer.num >= MAX_TRACERS) goto out;
+  if (query[0] == '/') {
+    for (p = query+1; *p && *p != '/'; p++)
+      if (*p == '\\' && p[1]) p++;
 
-  for (i=0; i<MAX_TRACERS; i++) {
-    if (!rbtracer.list[i].query) {
-      tracer = &rbtracer.list[i];
-      tracer_id = i;
-      break;
-    }
+    if (*p == '/' && (p[1] == '.' || p[1] == '#'))
+      return p+1;
+
+    return NULL; // a bare method regex
+  }
+
+  for (p = query; *p; p++)
+    if ((*p == '.' || *p == '#') && p[1] == '/')
+      return p;
+
+  if (NULL != (p = strrchr(query, '.')))
+    return p;
+
+  return strrchr(query, '#');
+}
+
+static bool
+rbtracer__is_klass_pattern(const char *str, size_t len)
+{
+  return len > 0 && (str[0] == '/' || memchr(str, '*', len));
+}
+
+static bool
+rbtracer__is_mid_pattern(const char *str)
+{
+  size_t len = strlen(str);
+  const char *p;
+
+  if (len > 2 && str[0] == '/' && str[len-1] == '/')
+    return true;
+
+  // operator methods like String#* and Integer#** are not globs
+  if (!strchr(str, '*'))
+    return false;
+  for (p = str; *p; p++)
+    if (*p == '_' || isalnum((unsigned char)*p))
+      return true;
+
+  return false;
+}
+
+#ifdef RUBY_VM
+static VALUE
+rbtracer__method_iseq(VALUE args)
+{
+  VALUE *argv = (VALUE *)args;
+  VALUE method = argv[0] ?
+    rb_funcall(argv[0], rb_intern("instance_method"), 1, argv[2]) :
+    rb_funcall(argv[1], rb_intern("method"), 1, argv[2]);
+  VALUE iseq = rb_funcall(rb_path2class("RubyVM::InstructionSequence"), rb_intern("of"), 1, method);
+
+  return NIL_P(iseq) ? Qnil : rb_funcall(iseq, rb_intern("path"), 0);
+}
+#endif
+
+// Which call events a tracer can match: methods defined in ruby only fire
+// call and return, everything else (cfuncs, attr_readers) c_call and
+// c_return. Selectors that aren't a single existing method get all four.
+static unsigned int
+rbtracer__events(rbtracer_t *tracer)
+{
+#ifdef RUBY_VM
+  if (tracer->is_pattern || !tracer->mid || rbtracer.devmode ||
+      (!tracer->klass && !tracer->self))
+    return RBTRACE_EVENTS_ALL;
+
+  // not defined yet
+  if (!rb_method_boundp(tracer->klass ? tracer->klass : CLASS_OF(tracer->self), tracer->mid, 0))
+    return RBTRACE_EVENTS_ALL;
+
+  int state = 0;
+  VALUE args[3] = {tracer->klass, tracer->self, ID2SYM(tracer->mid)};
+  VALUE path = rb_protect(rbtracer__method_iseq, (VALUE)args, &state);
+
+  if (state) {
+    rb_set_errinfo(Qnil);
+    return RBTRACE_EVENTS_ALL;
+  }
+
+  if (NIL_P(path))
+    return RBTRACE_EVENTS_CFUNC;
+
+  // builtins written in ruby may be traced like cfuncs in some versions
+  if (TYPE(path) == T_STRING && RSTRING_LEN(path) > 10 &&
+      0 == strncmp(RSTRING_PTR(path), "<internal:", 10))
+    return RBTRACE_EVENTS_ALL;
+
+  return RBTRACE_EVENTS_RUBY;
+#else
+  return RBTRACE_EVENTS_ALL;
+#endif
+}
+
+static VALUE
+rbtracer__path_to_class(VALUE name)
+{
+  return rb_path_to_class(name);
+}
+
+// Returns the class or module with the given name, or 0 if there is none.
+// Commands may be run on the wakeup thread, which has no ruby frame to eval
+// the name in, so the constant is looked up directly.
+static VALUE
+rbtracer__lookup(char *name)
+{
+  int state = 0;
+  VALUE val = rb_protect(rbtracer__path_to_class, rb_str_new_cstr(name), &state);
+
+  if (state) {
+    rb_set_errinfo(Qnil);
+    return 0;
+  }
+
+  return val;
+}
+
+static VALUE
+rbtracer__resolve(char *name)
+{
+  st_data_t val;
+
+  if (!rbtracer.resolve_tbl)
+    return rbtracer__lookup(name);
+
+  if (!st_lookup(rbtracer.resolve_tbl, (st_data_t)name, &val)) {
+    val = (st_data_t)rbtracer__lookup(name);
+    st_insert(rbtracer.resolve_tbl, (st_data_t)strdup(name), val);
+  }
+
+  return (VALUE)val;
+}
+
+static rbtracer_t *
+rbtracer__alloc()
+{
+  unsigned int i, size;
+
+  for (i=0; i<rbtracer.list_size; i++) {
+    if (!rbtracer.list[i].query)
+      return &rbtracer.list[i];
   }
-  if (!tracer) goto out;
 
+  size = rbtracer.list_size ? rbtracer.list_size * 2 : 64;
+  rbtracer_t *list = realloc(rbtracer.list, size * sizeof(rbtracer_t));
+  if (!list)
+    return NULL;
+
+  memset(list + rbtracer.list_size, 0, (size - rbtracer.list_size) * sizeof(rbtracer_t));
+  rbtracer.list = list;
+  rbtracer.list_size = size;
+
+  return &rbtracer.list[i];
+}
+
+// Parses a selector into tracer. Its class is looked up when resolve is set,
+// and otherwise left to be matched by name. Returns false if the selector is
+// invalid, or names a class that does not exist.
+static bool
+rbtracer__parse(rbtracer_t *tracer, char *query, bool resolve)
+{
   size_t
     klass_begin = 0,
     klass_end = 0;
 
-  bool is_singleton = false;
+  bool
+    is_singleton = false,
+    is_pattern = false;
 
   VALUE
     klass = 0,
@@ -689,57 +5050,68 @@ rbtracer_add(char *query, bool is_slow)
 
   ID mid = 0;
 
+  char *method = NULL;
+
   { // resolve query into its parts
-    char
-      *idx = NULL,
-      *method = NULL;
+    char *idx = rbtracer__find_separator(query);
 
-    if (NULL != (idx = strrchr(query, '.'))) {
+    if (idx) {
       klass_begin = 0;
       klass_end = idx - query;
-      is_singleton = true;
-
-      *idx = 0;
-      if (!rbtracer.devmode)
-        self = rb_eval_string_protect(query, 0);
-      *idx = '.';
-
+      is_singleton = (*idx == '.');
       method = idx+1;
+    } else {
+      method = query;
+    }
 
-    } else if (NULL != (idx = strrchr(query, '#'))) {
-      klass_begin = 0;
-      klass_end = idx - query;
-      is_singleton = false;
-
-      *idx = 0;
-      if (!rbtracer.devmode)
-        klass = rb_eval_string_protect(query, 0);
-      *idx = '#';
+    is_pattern =
+      rbtracer__is_klass_pattern(query + klass_begin, klass_end - klass_begin) ||
+      rbtracer__is_mid_pattern(method);
 
-      method = idx+1;
+    if (!is_pattern && resolve && klass_end != klass_begin) {
+      char sep = *idx;
 
-    } else {
-      method = query;
+      *idx = 0;
+      if (is_singleton)
+        self = rbtracer__resolve(query);
+      else
+        klass = rbtracer__resolve(query);
+      *idx = sep;
+
+      // an unknown class must not turn into a wildcard
+      if (!self && !klass)
+        return false;
     }
 
-    if (method && *method) {
+    if (method && *method && !rbtracer__is_mid_pattern(method)) {
       mid = rb_intern(method);
     }
   }
 
-  if (rbtracer.devmode) {
-    if (!mid && (klass_begin == klass_end))
-      goto out;
+  if (is_pattern || !resolve) {
+    if (!mid && !is_pattern && (klass_begin == klass_end))
+      return false;
   } else {
     if (!mid && !klass && !self)
-      goto out;
+      return false;
   }
 
-  memset(tracer, 0, sizeof(*tracer));
+  rbtracer_pattern_t
+    klass_pattern = {},
+    mid_pattern = {};
 
-  tracer->id = tracer_id;
+  if (is_pattern) {
+    if (!rbtracer_pattern_init(&klass_pattern, query + klass_begin, klass_end - klass_begin))
+      return false;
+
+    if (!mid && !rbtracer_pattern_init(&mid_pattern, method, strlen(method))) {
+      rbtracer_pattern_free(&klass_pattern);
+      return false;
+    }
+  }
+
+  memset(tracer, 0, sizeof(*tracer));
   tracer->query = strdup(query);
-  tracer->is_slow = is_slow;
 
   if (klass_end != klass_begin) {
     tracer->klass_name = tracer->query + klass_begin;
@@ -751,62 +5123,237 @@ rbtracer_add(char *query, bool is_slow)
   tracer->klass = klass;
   tracer->mid = mid;
 
-  if (rbtracer.num == 0)
-    event_hook_install();
+  if (is_pattern) {
+    tracer->is_pattern = true;
+    tracer->klass_pattern = klass_pattern;
+    tracer->mid_pattern = mid_pattern;
+  }
+
+  return true;
+}
+
+// Recomputes which call events the tracers naming a method of klass (or of
+// self, for singleton methods) can match, after it gained one.
+static void
+rbtracer__events_refresh(VALUE klass, bool singleton)
+{
+  unsigned int i, n, events;
+  bool changed = false;
+
+  for (i=0, n=0; i<rbtracer.list_size && n<rbtracer.num; i++) {
+    rbtracer_t *curr = &rbtracer.list[i];
+    if (!curr->query) continue;
+    n++;
+
+    if (curr->is_pattern || !curr->mid || (singleton ? curr->self : curr->klass) != klass)
+      continue;
+
+    events = rbtracer__events(curr);
+    if (events == curr->events)
+      continue;
+
+    if (curr->events & RBTRACE_EVENTS_RUBY)
+      rbtracer.num_ruby_events--;
+    if (curr->events & RBTRACE_EVENTS_CFUNC)
+      rbtracer.num_cfunc_events--;
+    curr->events = events;
+    if (curr->events & RBTRACE_EVENTS_RUBY)
+      rbtracer.num_ruby_events++;
+    if (curr->events & RBTRACE_EVENTS_CFUNC)
+      rbtracer.num_cfunc_events++;
+    changed = true;
+  }
+
+  if (metrics__names(klass, singleton)) {
+    metrics__events_refresh();
+    changed = true;
+  }
+
+  if (changed)
+    event_hook_update();
+}
+
+static int
+rbtracer_add(char *query, bool is_slow)
+{
+  int tracer_id = -1;
+  rbtracer_t *tracer = rbtracer__alloc();
+
+  if (!tracer || !rbtracer__parse(tracer, query, !rbtracer.devmode))
+    goto out;
+
+  tracer_id = tracer - rbtracer.list;
+  tracer->id = tracer_id;
+  tracer->is_slow = is_slow;
+
+  if (tracer->is_pattern)
+    rbtracer.num_patterns++;
+  rbtracer_patterns_clear();
+
+  tracer->events = rbtracer__events(tracer);
+  if (tracer->events & RBTRACE_EVENTS_RUBY)
+    rbtracer.num_ruby_events++;
+  if (tracer->events & RBTRACE_EVENTS_CFUNC)
+    rbtracer.num_cfunc_events++;
+  if (!tracer->is_pattern && tracer->mid && (tracer->klass || tracer->self))
+    rbtracer.num_watched++;
 
   rbtracer.num++;
   if (tracer->is_slow)
     rbtracer.num_slow++;
 
 out:
-  rbtrace__send_event(2,
-    "add",
-    'd', tracer_id,
-    's', query
-  );
   return tracer_id;
 }
 
-static void
+static int
 rbtracer_add_expr(int id, char *expr)
 {
   int expr_id = -1;
-  int tracer_id = -1;
   rbtracer_t *tracer = NULL;
 
-  if (id >= MAX_TRACERS) goto out;
+  if (id < 0 || id >= (int)rbtracer.list_size) goto out;
   tracer = &rbtracer.list[id];
 
   if (tracer->query) {
-    tracer_id = tracer->id;
+    char **exprs = realloc(tracer->exprs, (tracer->num_exprs + 1) * sizeof(char *));
+    if (!exprs) goto out;
 
-    if (tracer->num_exprs < MAX_EXPRS) {
-      expr_id = tracer->num_exprs++;
-      tracer->exprs[expr_id] = strdup(expr);
-    }
+    tracer->exprs = exprs;
+    expr_id = tracer->num_exprs++;
+    tracer->exprs[expr_id] = strdup(expr);
   }
 
 out:
-  rbtrace__send_event(3,
-    "newexpr",
-    'd', tracer_id,
-    'd', expr_id,
-    's', expr
-  );
+  return expr_id;
+}
+
+static int
+rbtracer__free_key(st_data_t key, st_data_t val, st_data_t arg)
+{
+  free((char *)key);
+  return ST_CONTINUE;
+}
+
+// Add a batch of tracers in one go, from an array of
+// [selector, is_slow, [expr, ...]] entries. Class names are only
+// resolved once per batch, and the tracer ids are sent back in chunks.
+static void
+rbtracer_add_all(msgpack_object_array *entries)
+{
+  uint32_t i, j, offset = 0;
+  int64_t ids[ADDALL_CHUNK];
+  int num_ids = 0;
+
+  rbtracer.resolve_tbl = st_init_strtable();
+
+  for (i=0; i<entries->size; i++) {
+    msgpack_object *entry = &entries->ptr[i];
+    int tracer_id = -1;
+
+    if (entry->type == MSGPACK_OBJECT_ARRAY &&
+        entry->via.array.size == 3 &&
+        entry->via.array.ptr[0].type == MSGPACK_OBJECT_STR &&
+        entry->via.array.ptr[1].type == MSGPACK_OBJECT_BOOLEAN &&
+        entry->via.array.ptr[2].type == MSGPACK_OBJECT_ARRAY)
+    {
+      msgpack_object_str str = entry->via.array.ptr[0].via.str;
+      msgpack_object_array exprs = entry->via.array.ptr[2].via.array;
+
+      char *query = strndup(str.ptr, str.size);
+      tracer_id = rbtracer_add(query, entry->via.array.ptr[1].via.boolean);
+      free(query);
+
+      for (j=0; tracer_id != -1 && j<exprs.size; j++) {
+        if (exprs.ptr[j].type != MSGPACK_OBJECT_STR) continue;
+
+        char *expr = strndup(exprs.ptr[j].via.str.ptr, exprs.ptr[j].via.str.size);
+        rbtracer_add_expr(tracer_id, expr);
+        free(expr);
+      }
+    }
+
+    ids[num_ids++] = tracer_id;
+
+    if (num_ids == ADDALL_CHUNK || i+1 == entries->size) {
+      rbtrace__send_event(2,
+        "added",
+        'u', offset,
+        'a', num_ids, ids
+      );
+      offset += num_ids;
+      num_ids = 0;
+    }
+  }
+
+  st_foreach(rbtracer.resolve_tbl, rbtracer__free_key, 0);
+  st_free_table(rbtracer.resolve_tbl);
+  rbtracer.resolve_tbl = NULL;
 }
 
 static void
 rbtracer_watch(uint32_t threshold, bool cpu_time)
 {
   if (!rbtracer.slow) {
-    rbtracer.num_calls = 0;
+    rbtracer.calls_serial++;
     rbtracer.threshold = threshold;
     rbtracer.firehose = false;
     rbtracer.slow = true;
     rbtracer.slowcpu = cpu_time;
 
-    event_hook_install();
+    // slow method tracers can match from now on
+    rbtracer_patterns_clear();
+  }
+}
+
+// Commands can also be sent over a unix stream socket in the abstract
+// namespace (linux only), as length-prefixed msgpack frames of any size. The
+// socket needs no cleanup and goes away with the process, unlike a msgq.
+static void
+control_teardown()
+{
+  if (rbtracer.ctl_fd != -1) {
+    close(rbtracer.ctl_fd);
+    rbtracer.ctl_fd = -1;
+  }
+
+  if (rbtracer.ctl_listen_fd != -1) {
+    close(rbtracer.ctl_listen_fd);
+    rbtracer.ctl_listen_fd = -1;
   }
+
+  rbtracer.ctl_pid = 0;
+  rbtracer.ctl_len = 0;
+}
+
+static bool
+control_setup(pid_t pid)
+{
+#ifdef PLATFORM_LINUX
+  struct sockaddr_un addr = {.sun_family = AF_UNIX};
+  socklen_t len;
+  int fd;
+
+  // leading NUL byte for the abstract namespace
+  snprintf(addr.sun_path + 1, sizeof(addr.sun_path) - 1, "rbtrace-%d", pid);
+  len = offsetof(struct sockaddr_un, sun_path) + 1 + strlen(addr.sun_path + 1);
+
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd == -1)
+    return false;
+
+  if (bind(fd, (struct sockaddr *)&addr, len) == -1 ||
+      listen(fd, 4) == -1) {
+    close(fd);
+    return false;
+  }
+
+  rbtracer.ctl_listen_fd = fd;
+  rbtracer.ctl_pid = pid;
+  return true;
+#else
+  return false;
+#endif
 }
 
 static void
@@ -814,9 +5361,13 @@ msgq_teardown()
 {
   pid_t pid = getpid();
 
+  control_teardown();
+
   if (rbtracer.mqo_fd != -1) {
-    close(rbtracer.mqo_fd);
-    rbtracer.mqo_fd = -1;
+    // leak the socket rather than close it under a writer stuck sending
+    if (writer_flush())
+      close(rbtracer.mqo_fd);
+    __atomic_store_n(&rbtracer.mqo_fd, -1, __ATOMIC_RELAXED);
   }
 
   if (rbtracer.mqi_id != -1 && rbtracer.mqi_key == (key_t)-pid) {
@@ -838,7 +5389,7 @@ msgq_setup()
   pid_t pid = getpid();
   int val;
 
-  if (rbtracer.mqi_key != (key_t)-pid ||
+  if ((rbtracer.mqi_key != (key_t)-pid && rbtracer.ctl_pid != pid) ||
       rbtracer.mqo_fd  == -1) {
     msgq_teardown();
   } else {
@@ -846,11 +5397,13 @@ msgq_setup()
   }
 
 
-  rbtracer.mqi_key = (key_t) -pid;
-  rbtracer.mqi_id  = msgget(rbtracer.mqi_key, 0666 | IPC_CREAT);
+  if (!control_setup(pid)) {
+    rbtracer.mqi_key = (key_t) -pid;
+    rbtracer.mqi_id  = msgget(rbtracer.mqi_key, 0666 | IPC_CREAT);
 
-  if (rbtracer.mqi_id == -1)
-    fprintf(stderr, "msgget() failed to create msgq\n");
+    if (rbtracer.mqi_id == -1)
+      fprintf(stderr, "msgget() failed to create msgq\n");
+  }
 
 
   rbtracer.mqo_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
@@ -866,18 +5419,51 @@ msgq_setup()
   val = 1;
   setsockopt(rbtracer.mqo_fd, SOL_SOCKET, SO_NOSIGPIPE, &val, sizeof(int));
 #endif
+
+  writer_setup();
 }
 
-static VALUE rbtrace_module;
+static VALUE rbtrace_module;
+
+static void
+  rbtrace__process_event(msgpack_object cmd),
+  rbtrace__drain();
+
+// Commands larger than one msgq message arrive as a series of
+// ["frag", total_size, chunk] messages, and are processed once complete.
+static void
+rbtrace__process_fragment(size_t total, const char *chunk, size_t len)
+{
+  if (rbtracer.frag_total != total || rbtracer.frag_len + len > total) {
+    // start of a new command (or garbage), drop anything half assembled
+    free(rbtracer.frag_buf);
+    rbtracer.frag_buf = malloc(total);
+    rbtracer.frag_len = 0;
+    rbtracer.frag_total = rbtracer.frag_buf ? total : 0;
+
+    if (!rbtracer.frag_buf || len > total)
+      return;
+  }
+
+  memcpy(rbtracer.frag_buf + rbtracer.frag_len, chunk, len);
+  rbtracer.frag_len += len;
+
+  if (rbtracer.frag_len == rbtracer.frag_total) {
+    char *buf = rbtracer.frag_buf;
+    size_t size = rbtracer.frag_len;
+
+    rbtracer.frag_buf = NULL;
+    rbtracer.frag_len = rbtracer.frag_total = 0;
+
+    msgpack_unpacked unpacked;
+    msgpack_unpacked_init(&unpacked);
 
-static VALUE
-eval_inspect(VALUE rb_code) {
-  return rb_funcall(rbtrace_module, rb_intern("eval_and_inspect"), 1, rb_code);
-}
+    if (msgpack_unpack_next(&unpacked, buf, size, NULL))
+      rbtrace__process_event(unpacked.data);
 
-static VALUE
-rescue_inspect(VALUE arg, VALUE exception) {
-  return rb_funcall(exception, rb_intern("inspect"), 0);
+    msgpack_unpacked_destroy(&unpacked);
+    free(buf);
+  }
 }
 
 static void
@@ -887,9 +5473,7 @@ rbtrace__process_event(msgpack_object cmd)
     return;
 
   static int last_tracer_id = -1; // hax
-  char query[BUF_SIZE];
-
-  VALUE val = Qnil;
+  char *query;
 
   msgpack_object_array ary;
   msgpack_object_str str;
@@ -939,9 +5523,82 @@ rbtrace__process_event(msgpack_object cmd)
     unsigned int msec = ary.ptr[1].via.u64;
     rbtracer_watch(msec, str.size > 5 /* watchcpu */);
 
+  } else if (0 == strncmp("adaptive", str.ptr, str.size)) {
+    if (ary.size != 3 ||
+        ary.ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER ||
+        ary.ptr[2].type != MSGPACK_OBJECT_POSITIVE_INTEGER ||
+        ary.ptr[1].via.u64 == 0 || ary.ptr[1].via.u64 >= 1000)
+      return;
+
+    adaptive_start(ary.ptr[1].via.u64, ary.ptr[2].via.u64);
+
+  } else if (0 == strncmp("record", str.ptr, str.size)) {
+    if (ary.size != 4 ||
+        ary.ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER ||
+        ary.ptr[2].type != MSGPACK_OBJECT_POSITIVE_INTEGER ||
+        ary.ptr[3].type != MSGPACK_OBJECT_BOOLEAN)
+      return;
+
+    // a zero threshold turns the recorder off
+    if (ary.ptr[1].via.u64 > 0)
+      recorder_start(ary.ptr[1].via.u64, ary.ptr[2].via.u64, ary.ptr[3].via.boolean);
+    else
+      recorder_stop();
+
+  } else if (0 == strncmp("recdump", str.ptr, str.size)) {
+    recorder_send();
+
+  } else if (0 == strncmp("tail", str.ptr, str.size)) {
+    if (ary.size != 2 ||
+        ary.ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER)
+      return;
+
+    tail_start(ary.ptr[1].via.u64);
+
+  } else if (0 == strncmp("gvl", str.ptr, str.size)) {
+    bool started = gvl_start();
+
+    rbtrace__send_event(1,
+      "gvlstarted",
+      'b', started
+    );
+
+  } else if (0 == strncmp("gvldump", str.ptr, str.size)) {
+    gvl_dump();
+
+  } else if (0 == strncmp("io", str.ptr, str.size)) {
+    io_start();
+
+  } else if (0 == strncmp("iodump", str.ptr, str.size)) {
+    io_dump();
+
+  } else if (0 == strncmp("aggregate", str.ptr, str.size)) {
+    if (ary.size != 2 ||
+        ary.ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER)
+      return;
+
+    agg_start(ary.ptr[1].via.u64);
+
+  } else if (0 == strncmp("aggdump", str.ptr, str.size)) {
+    agg_dump();
+
+  } else if (0 == strncmp("profile", str.ptr, str.size)) {
+    prof_start();
+
+  } else if (0 == strncmp("profdump", str.ptr, str.size)) {
+    prof_dump();
+
   } else if (0 == strncmp("firehose", str.ptr, str.size)) {
     rbtracer.firehose = true;
-    event_hook_install();
+
+  } else if (0 == strncmp("threads", str.ptr, str.size)) {
+    rbtracer.threads = true;
+
+  } else if (0 == strncmp("cputime", str.ptr, str.size)) {
+    if (!rbtracer.cputime) {
+      rbtracer.calls_serial++;
+      rbtracer.cputime = true;
+    }
 
   } else if (0 == strncmp("add", str.ptr, str.size)) {
     if (ary.size != 3 ||
@@ -952,10 +5609,23 @@ rbtrace__process_event(msgpack_object cmd)
     str = ary.ptr[1].via.str;
     bool is_slow = ary.ptr[2].via.boolean;
 
-    strncpy(query, str.ptr, str.size);
-    query[str.size] = 0;
+    query = strndup(str.ptr, str.size);
     last_tracer_id = rbtracer_add(query, is_slow);
 
+    rbtrace__send_event(2,
+      "add",
+      'd', last_tracer_id,
+      's', query
+    );
+    free(query);
+
+  } else if (0 == strncmp("addall", str.ptr, str.size)) {
+    if (ary.size != 2 ||
+        ary.ptr[1].type != MSGPACK_OBJECT_ARRAY)
+      return;
+
+    rbtracer_add_all(&ary.ptr[1].via.array);
+
   } else if (0 == strncmp("addexpr", str.ptr, str.size)) {
     if (ary.size != 2 ||
         ary.ptr[1].type != MSGPACK_OBJECT_STR)
@@ -963,9 +5633,36 @@ rbtrace__process_event(msgpack_object cmd)
 
     str = ary.ptr[1].via.str;
 
-    strncpy(query, str.ptr, str.size);
-    query[str.size] = 0;
-    rbtracer_add_expr(last_tracer_id, query);
+    query = strndup(str.ptr, str.size);
+    int expr_id = rbtracer_add_expr(last_tracer_id, query);
+
+    rbtrace__send_event(3,
+      "newexpr",
+      'd', expr_id == -1 ? -1 : last_tracer_id,
+      'd', expr_id,
+      's', query
+    );
+    free(query);
+
+  } else if (0 == strncmp("exprlimit", str.ptr, str.size)) {
+    if (ary.size != 4 ||
+        ary.ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER ||
+        ary.ptr[2].type != MSGPACK_OBJECT_POSITIVE_INTEGER ||
+        ary.ptr[3].type != MSGPACK_OBJECT_POSITIVE_INTEGER)
+      return;
+
+    rbtracer.expr_max_len = ary.ptr[1].via.u64;
+    rbtracer.expr_max_rate = ary.ptr[2].via.u64;
+    rbtracer.expr_sample = ary.ptr[3].via.u64;
+
+  } else if (0 == strncmp("frag", str.ptr, str.size)) {
+    if (ary.size != 3 ||
+        ary.ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER ||
+        (ary.ptr[2].type != MSGPACK_OBJECT_BIN &&
+         ary.ptr[2].type != MSGPACK_OBJECT_STR))
+      return;
+
+    rbtrace__process_fragment(ary.ptr[1].via.u64, ary.ptr[2].via.bin.ptr, ary.ptr[2].via.bin.size);
 
   } else if (0 == strncmp("gc", str.ptr, str.size)) {
     rbtracer.gc = true;
@@ -974,13 +5671,13 @@ rbtrace__process_event(msgpack_object cmd)
 #endif
 
   } else if (0 == strncmp("devmode", str.ptr, str.size)) {
-    rbtracer.devmode = true;
+    devmode_install();
 
   } else if (0 == strncmp("fork", str.ptr, str.size)) {
     pid_t outer = fork();
 
     if (outer == 0) {
-      rb_eval_string_protect("$0 = \"[DEBUG] #{Process.ppid}\"", 0);
+      rb_gv_set("$0", rb_sprintf("[DEBUG] %d", (int)getppid()));
 
 #if defined(PLATFORM_FREEBSD) || defined(PLATFORM_OPENBSD)
       // The call setpgrp() is equivalent to setpgid(0,0).
@@ -1019,35 +5716,174 @@ rbtrace__process_event(msgpack_object cmd)
       waitpid(outer, NULL, 0);
     }
 
-  } else if (0 == strncmp("eval", str.ptr, str.size)) {
+  } else if (0 == strncmp("backtraces", str.ptr, str.size)) {
     if (ary.size != 2 ||
-        ary.ptr[1].type != MSGPACK_OBJECT_STR)
+        (ary.ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER &&
+         ary.ptr[1].type != MSGPACK_OBJECT_NEGATIVE_INTEGER))
       return;
 
-    str = ary.ptr[1].via.str;
+    rbtrace_backtraces((int)ary.ptr[1].via.i64);
 
-    strncpy(query, str.ptr, str.size);
-    query[str.size] = 0;
+  } else if (0 == strncmp("aeval", str.ptr, str.size)) {
+    if (ary.size != 3 ||
+        ary.ptr[1].type != MSGPACK_OBJECT_POSITIVE_INTEGER ||
+        ary.ptr[2].type != MSGPACK_OBJECT_STR)
+      return;
 
-    VALUE rb_code;
-    rb_code = rb_str_new2(query);
+    // runs in its own thread, which streams the result back when done
+    str = ary.ptr[2].via.str;
+    rb_funcall(rbtrace_module, rb_intern("eval_async"), 2,
+      ULONG2NUM(ary.ptr[1].via.u64), rb_str_new(str.ptr, str.size));
+  }
 
-    val = rb_rescue(eval_inspect, rb_code, rescue_inspect, Qnil);
+  // most commands change what is traced, or how
+  event_hook_update();
+}
 
-    if (TYPE(val) == T_STRING) {
-      rbtrace__send_event(1,
-        "evaled",
-        's', RSTRING_PTR(val)
-      );
+// Anyone can connect to an abstract socket, so only the process's own user
+// and root are let in, like for signals and the msgq.
+static bool
+control_peer_allowed(int fd)
+{
+#ifdef PLATFORM_LINUX
+  struct ucred cred;
+  socklen_t len = sizeof(cred);
+
+  if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == -1)
+    return false;
+
+  return cred.uid == 0 || cred.uid == getuid() || cred.uid == geteuid();
+#else
+  return false;
+#endif
+}
+
+static void
+control_receive()
+{
+  int fd;
+  bool eof = false;
+
+  // the newest client wins, an older connection must be stale
+  while (-1 != (fd = accept(rbtracer.ctl_listen_fd, NULL, NULL))) {
+    if (!control_peer_allowed(fd)) {
+      close(fd);
+      continue;
+    }
+
+    if (rbtracer.ctl_fd != -1)
+      close(rbtracer.ctl_fd);
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    rbtracer.ctl_fd = fd;
+    rbtracer.ctl_len = 0;
+
+    // have the wakeup thread watch the new connection
+    wakeup_signal(0);
+  }
+
+  if (rbtracer.ctl_fd == -1)
+    return;
+
+  while (true) {
+    if (rbtracer.ctl_size - rbtracer.ctl_len < 4096) {
+      size_t size = rbtracer.ctl_size ? rbtracer.ctl_size * 2 : 16384;
+      char *buf = realloc(rbtracer.ctl_buf, size);
+      if (!buf) break;
+
+      rbtracer.ctl_buf = buf;
+      rbtracer.ctl_size = size;
+    }
+
+    ssize_t n = read(rbtracer.ctl_fd, rbtracer.ctl_buf + rbtracer.ctl_len, rbtracer.ctl_size - rbtracer.ctl_len);
+
+    if (n > 0) {
+      rbtracer.ctl_len += n;
+    } else if (n == 0) {
+      eof = true;
+      break;
+    } else if (errno != EINTR) {
+      break;
     }
   }
+
+  // pull out complete frames first, since processing them can tear down
+  // the control socket along with its buffer
+  size_t off = 0;
+  uint32_t size;
+
+  while (rbtracer.ctl_len - off >= 4) {
+    memcpy(&size, rbtracer.ctl_buf + off, 4);
+    size = ntohl(size);
+
+    if (rbtracer.ctl_len - off - 4 < size)
+      break;
+    off += 4 + size;
+  }
+
+  char *frames = NULL;
+  if (off > 0) {
+    frames = malloc(off);
+    memcpy(frames, rbtracer.ctl_buf, off);
+    memmove(rbtracer.ctl_buf, rbtracer.ctl_buf + off, rbtracer.ctl_len - off);
+    rbtracer.ctl_len -= off;
+  }
+
+  if (eof) {
+    close(rbtracer.ctl_fd);
+    rbtracer.ctl_fd = -1;
+    rbtracer.ctl_len = 0;
+  }
+
+  size_t pos = 0;
+  while (pos < off) {
+    memcpy(&size, frames + pos, 4);
+    size = ntohl(size);
+
+    msgpack_unpacked unpacked;
+    msgpack_unpacked_init(&unpacked);
+
+    if (msgpack_unpack_next(&unpacked, frames + pos + 4, size, NULL))
+      rbtrace__process_event(unpacked.data);
+
+    msgpack_unpacked_destroy(&unpacked);
+    pos += 4 + size;
+  }
+  free(frames);
+
+  // the client went away without detaching
+  if (eof && rbtracer.attached_pid)
+    rbtracer_detach();
 }
 
 static void
 rbtrace__receive(void *data)
+{
+  // the signal may reach us both as a postponed job and through the wakeup
+  // thread, and a command (eval) can let the other one run halfway through
+  if (in_receive) return;
+
+  in_receive++;
+  wakeup_setup();
+  rbtrace__drain();
+  in_receive--;
+}
+
+static void
+rbtrace__drain()
 {
   msgq_setup();
-  if (rbtracer.mqi_id == -1) return;
+  writer_check();
+  if (rbtracer.mqi_id == -1 && rbtracer.ctl_listen_fd == -1) return;
+
+  if (!rbtracer.attached_pid) {
+    rbtrace__send_handshake(2,
+      "ready",
+      'u', (uint32_t) getpid(),
+      'b', rbtracer.ctl_listen_fd != -1 // client should connect to the control socket
+    );
+  }
 
 #ifdef HAVE_RB_DURING_GC
   if (rb_during_gc()) {
@@ -1056,6 +5892,12 @@ rbtrace__receive(void *data)
   }
 #endif
 
+  if (rbtracer.ctl_listen_fd != -1)
+    control_receive();
+
+  if (rbtracer.mqi_id == -1)
+    return;
+
   event_msg_t msg;
   int n = 0;
 
@@ -1072,17 +5914,125 @@ rbtrace__receive(void *data)
       msgpack_unpacked_init(&unpacked);
 
       bool success = msgpack_unpack_next(&unpacked, msg.buf, sizeof(msg.buf), NULL);
-      if (!success) continue;
+      if (success)
+        rbtrace__process_event(unpacked.data);
 
-      rbtrace__process_event(unpacked.data);
+      msgpack_unpacked_destroy(&unpacked);
     }
   }
 }
 
+static int
+rbtrace__mark_key(st_data_t key, st_data_t val, st_data_t arg)
+{
+  rb_gc_mark((VALUE)key);
+  return ST_CONTINUE;
+}
+
+static int
+rbtrace__mark_stack_key(st_data_t key, st_data_t val, st_data_t arg)
+{
+  rbtrace_stack_t *stack = (rbtrace_stack_t *)key;
+  int i;
+
+  for (i=0; i<stack->num; i++)
+    rb_gc_mark(stack->frames[i]);
+
+  return ST_CONTINUE;
+}
+
+static int
+rbtrace__mark_pattern_key(st_data_t key, st_data_t val, st_data_t arg)
+{
+  rb_gc_mark((VALUE)(key & ~(st_data_t)1));
+  return ST_CONTINUE;
+}
+
 static void
 rbtrace_gc_mark(void *ptr)
 {
-  if (rbtracer.gc && !in_event_hook) {
+  unsigned int i, n;
+  rbtrace_local_t *local;
+
+  // classes we have cached names or matches for must stay alive, otherwise
+  // their slots could be reused by another class with a stale cache entry
+  if (rbtracer.klass_tbl)
+    st_foreach(rbtracer.klass_tbl, rbtrace__mark_key, 0);
+
+  for (i=0, n=0; i<rbtracer.list_size && n<rbtracer.num; i++) {
+    rbtracer_t *curr = &rbtracer.list[i];
+    if (!curr->query) continue;
+    n++;
+
+    if (curr->klass_cache)
+      st_foreach(curr->klass_cache, rbtrace__mark_key, 0);
+  }
+
+  if (rbtracer.pattern_tbl)
+    st_foreach(rbtracer.pattern_tbl, rbtrace__mark_pattern_key, 0);
+  if (adaptive.tbl)
+    st_foreach(adaptive.tbl, rbtrace__mark_pattern_key, 0);
+  if (prof.tbl)
+    st_foreach(prof.tbl, rbtrace__mark_pattern_key, 0);
+  if (prof.dump)
+    st_foreach(prof.dump, rbtrace__mark_pattern_key, 0);
+  if (metrics.tbl)
+    st_foreach(metrics.tbl, rbtrace__mark_pattern_key, 0);
+
+  // as are frames of the stacks we have sent
+  if (rbtracer.stack_tbl)
+    st_foreach(rbtracer.stack_tbl, rbtrace__mark_stack_key, 0);
+  if (backtrace.frame_tbl)
+    st_foreach(backtrace.frame_tbl, rbtrace__mark_key, 0);
+  for (i=0; i<(unsigned int)backtrace.num; i++)
+    rb_gc_mark(backtrace.frames[i]);
+
+  locals_lock();
+  for (local = locals; local; local = local->next)
+    for (i=0; i<local->tail_num; i++)
+      if (local->tail_events[i].klass)
+        rb_gc_mark(local->tail_events[i].klass);
+  locals_unlock();
+
+  // IO objects keep their targets until the next dump
+  if (io.io_tbl)
+    st_foreach(io.io_tbl, rbtrace__mark_key, 0);
+  for (i=0; io.stats && i<IO_MAX_STATS; i++) {
+    if (io.stats[i].klass)
+      rb_gc_mark(io.stats[i].klass);
+    if (io.stats[i].caller)
+      rb_gc_mark(io.stats[i].caller);
+  }
+  for (i=0; io.dump && i<IO_MAX_STATS; i++) {
+    if (io.dump[i].klass)
+      rb_gc_mark(io.dump[i].klass);
+    if (io.dump[i].caller)
+      rb_gc_mark(io.dump[i].caller);
+  }
+
+#ifdef HAVE_RB_INTERNAL_THREAD_SPECIFIC_GET
+  for (i=0; i<GVL_MAX_METHODS; i++)
+    if (gvl.methods[i].klass)
+      rb_gc_mark(gvl.methods[i].klass);
+#endif
+
+  if (recorder.ring) {
+    uint64_t end = recorder.count < RECORDER_SIZE ? recorder.count : RECORDER_SIZE;
+    for (i=0; i<end; i++)
+      if (recorder.ring[i].klass)
+        rb_gc_mark(recorder.ring[i].klass);
+
+    if (recorder.gc)
+      recorder_add('g', timeofday_usec(), 0, 0, 0, 0, false);
+  }
+
+  for (i=0; i<recorder.num_dump; i++)
+    if (recorder.dump[i].klass)
+      rb_gc_mark(recorder.dump[i].klass);
+
+  local = rbtrace_local();
+
+  if (rbtracer.gc && local && !local->in_event_hook) {
     rbtrace__send_event(1,
       "gc",
       'n'
@@ -1092,12 +6042,179 @@ rbtrace_gc_mark(void *ptr)
 
 static VALUE gc_hook;
 
+#ifdef RBTRACE_WAKEUP_THREAD
+// A postponed job only runs once a thread checks for interrupts, which a
+// process sleeping or blocked on I/O will not do for a while. While a client
+// is attached, this thread waits on a pipe written to by the signal handler
+// instead, so commands are picked up immediately either way. It is started
+// by the first signal and stops on detach, or when no client attached within
+// WAKEUP_IDLE ms, so a process nobody attaches to never keeps it around.
+static struct {
+  pid_t pid;
+  int fds[2]; // of the running thread, -1 once it is told to stop
+} wakeup = {
+  .pid = 0,
+  .fds = {-1, -1}
+};
+
+#define WAKEUP_IDLE 5000
+
+static void *
+wakeup_wait(void *data)
+{
+  int *pipe = data;
+  char buf[64];
+
+  // also wake up for control socket clients, who need not signal us at all.
+  // these are read without the GVL, but any change is followed by a wakeup.
+  struct pollfd fds[3] = {
+    {.fd = pipe[0], .events = POLLIN},
+    {.fd = rbtracer.ctl_listen_fd, .events = POLLIN},
+    {.fd = rbtracer.ctl_fd, .events = POLLIN}
+  };
+
+  int ret = poll(fds, 3, rbtracer.attached_pid ? -1 : WAKEUP_IDLE);
+
+  if (ret == 0)
+    return (void *)1; // timed out
+  if (ret == -1 && errno != EINTR)
+    sleep(1); // should never happen, but do not spin
+
+  if (fds[0].revents & POLLIN) {
+    while (read(pipe[0], buf, sizeof(buf)) == sizeof(buf));
+  }
+
+  return NULL;
+}
+
+static void
+wakeup__write(int fd)
+{
+  int saved_errno = errno;
+
+  if (fd != -1 && write(fd, "", 1) == -1) {
+    // pipe is full, so a wakeup is pending already
+  }
+
+  errno = saved_errno;
+}
+
+static void
+wakeup__interrupt(void *data)
+{
+  wakeup__write(((int *)data)[1]);
+}
+
+static void
+wakeup_signal(void *data)
+{
+  wakeup__write(wakeup.fds[1]);
+}
+
+// The thread owns its pipe, and closes it once it has been replaced or
+// stopped, so the signal handler never writes to a closed fd.
+static VALUE
+wakeup_thread(void *data)
+{
+  int *pipe = data;
+
+  while (wakeup.fds[0] == pipe[0] && wakeup.pid == getpid()) {
+    void *idle = rb_thread_call_without_gvl(wakeup_wait, pipe, wakeup__interrupt, pipe);
+    rb_thread_check_ints();
+
+    if (wakeup.fds[0] != pipe[0])
+      break;
+
+    // e.g. the signal sent along with a detach, or a client that gave up
+    if (idle && !rbtracer.attached_pid) {
+      wakeup_stop();
+      break;
+    }
+
+    rbtrace__receive(0);
+  }
+
+  close(pipe[0]);
+  close(pipe[1]);
+  free(pipe);
+  return Qnil;
+}
+
+static void
+wakeup_setup()
+{
+  pid_t pid = getpid();
+  if (wakeup.pid == pid && wakeup.fds[0] != -1)
+    return;
+
+  // threads do not survive a fork, so the pipe inherited from the parent
+  // is only closed, and a forked child starts its own on its first signal
+  if (wakeup.pid != pid && wakeup.fds[0] != -1) {
+    close(wakeup.fds[0]);
+    close(wakeup.fds[1]);
+  }
+
+  wakeup.pid = pid;
+  wakeup.fds[0] = wakeup.fds[1] = -1;
+
+  int *pipe_fds = malloc(2 * sizeof(int));
+  if (!pipe_fds)
+    return;
+
+  if (pipe(pipe_fds) == -1) {
+    free(pipe_fds);
+    return;
+  }
+
+  fcntl(pipe_fds[0], F_SETFL, fcntl(pipe_fds[0], F_GETFL) | O_NONBLOCK);
+  fcntl(pipe_fds[1], F_SETFL, fcntl(pipe_fds[1], F_GETFL) | O_NONBLOCK);
+  fcntl(pipe_fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(pipe_fds[1], F_SETFD, FD_CLOEXEC);
+
+  wakeup.fds[0] = pipe_fds[0];
+  wakeup.fds[1] = pipe_fds[1];
+
+  VALUE thread = rb_thread_create(wakeup_thread, pipe_fds);
+  rb_funcall(thread, rb_intern("name="), 1, rb_str_new_cstr("__RBTrace__"));
+}
+
+static void
+wakeup_stop()
+{
+  int fd = wakeup.fds[1];
+
+  if (wakeup.pid != getpid() || fd == -1)
+    return;
+
+  wakeup.fds[0] = wakeup.fds[1] = -1;
+  wakeup__write(fd);
+}
+#else
+static void
+wakeup_setup()
+{
+}
+
+static void
+wakeup_signal(void *data)
+{
+}
+
+static void
+wakeup_stop()
+{
+}
+#endif
+
 #if defined(HAVE_RB_POSTPONED_JOB_REGISTER_ONE) || !defined(RUBY_VM)
 static void
 sigurg(int signal)
 {
 #if defined(HAVE_RB_POSTPONED_JOB_REGISTER_ONE)
   rb_postponed_job_register_one(0, rbtrace__receive, 0);
+#ifdef RBTRACE_WAKEUP_THREAD
+  wakeup_signal(0);
+#endif
 #else
   rbtrace__receive(0);
 #endif
@@ -1132,6 +6249,82 @@ send_write(VALUE klass, VALUE val) {
   return Qnil;
 }
 
+// Streams the result of an async eval as "evalchunk" events numbered from 0,
+// then an "evaldone" with the number of chunks.
+static VALUE
+send_result(VALUE mod, VALUE id, VALUE val)
+{
+  uint32_t req = NUM2UINT(id);
+  long len, off;
+  uint32_t seq = 0;
+
+  StringValue(val);
+  len = RSTRING_LEN(val);
+
+  for (off=0; off<len && rbtracer.attached_pid; off+=EVAL_CHUNK, seq++) {
+    writer_wait(EVAL_CHUNK + 64);
+    rbtrace__send_event(3,
+      "evalchunk",
+      'u', req,
+      'u', seq,
+      'S', (int)(len - off < EVAL_CHUNK ? len - off : EVAL_CHUNK), RSTRING_PTR(val) + off
+    );
+  }
+
+  writer_wait(64);
+  rbtrace__send_event(2,
+    "evaldone",
+    'u', req,
+    'u', seq
+  );
+
+  return Qnil;
+}
+
+static VALUE
+recorder_start_m(VALUE mod, VALUE msec, VALUE seconds, VALUE gc)
+{
+  if (NUM2UINT(msec) > 0)
+    recorder_start(NUM2UINT(msec), NUM2UINT(seconds), RTEST(gc));
+  else
+    recorder_stop();
+
+  return Qnil;
+}
+
+static void
+recorder__push(recorder_entry_t *entry, void *arg)
+{
+  VALUE name = Qnil;
+
+  if (entry->type != 'g') {
+    const char *klass = entry->klass ? rb_class2name(entry->klass) : NULL;
+    name = rb_sprintf("%s%s%s",
+      klass ? klass : "",
+      klass ? (entry->singleton ? "." : "#") : "",
+      rb_id2name(entry->mid));
+  }
+
+  rb_ary_push((VALUE)arg, rb_ary_new3(5,
+    rb_str_new_cstr(entry->type == 'g' ? "gc" : entry->type == 's' ? "slow" : "cslow"),
+    ULL2NUM(entry->start),
+    ULL2NUM(entry->duration),
+    UINT2NUM(entry->depth),
+    name
+  ));
+}
+
+static VALUE
+recorder_entries_m(VALUE mod)
+{
+  VALUE entries = rb_ary_new();
+
+  if (recorder.ring)
+    recorder_each(recorder__push, (void *)entries);
+
+  return entries;
+}
+
 static const rb_data_type_t rbtrace_type = {
     "RBTrace",
     {
@@ -1143,12 +6336,22 @@ void
 Init_rbtrace()
 {
   rbtrace_module = rb_define_module("RBTrace");
+
+  id_method_added = rb_intern("method_added");
+  id_singleton_method_added = rb_intern("singleton_method_added");
+
   VALUE output = rb_define_module_under(rbtrace_module, "OUT");
 
   rb_const_set(rbtrace_module, rb_intern("BUF_SIZE"), INT2NUM(BUF_SIZE));
 
   rb_define_singleton_method(output, "write", send_write, 1);
 
+  rb_define_singleton_method(rbtrace_module, "_send_result", send_result, 2);
+  rb_define_singleton_method(rbtrace_module, "_recorder_start", recorder_start_m, 3);
+  rb_define_singleton_method(rbtrace_module, "recorder_entries", recorder_entries_m, 0);
+  rb_define_singleton_method(rbtrace_module, "_metrics_start", metrics_start_m, 2);
+  rb_define_singleton_method(rbtrace_module, "_metrics_stop", metrics_stop_m, 0);
+
   // hook into the gc
   rb_global_variable(&gc_hook);
   gc_hook = TypedData_Wrap_Struct(rb_cObject, &rbtrace_type, NULL);
@@ -1164,12 +6367,8 @@ Init_rbtrace()
   signal(SIGURG, sigurg);
 #endif
 
-  // setup msgpack
-  rbtracer.sbuf = msgpack_sbuffer_new();
-  rbtracer.msgpacker = msgpack_packer_new(rbtracer.sbuf, msgpack_sbuffer_write);
-
-  // zero out tracer
-  memset(&rbtracer.list, 0, sizeof(rbtracer.list));
+  // pack buffers and call stacks are set up on each thread as it needs them
+  rbtrace_local_setup();
 
   // cleanup the msgq on exit
   atexit(msgq_teardown);
@@ -0,0 +1,3 @@
+#define MSGPACK_VERSION_MAJOR    1
+#define MSGPACK_VERSION_MINOR    1
+#define MSGPACK_VERSION_REVISION 0
@@ -2,13 +2,59 @@
 
 module RBTrace
   class << self
-    def eval_and_inspect(code)
-      t = Thread.new do
+    # Evaluate code without blocking the caller, and stream the result back
+    # to the attached tracer tagged with id.
+    def eval_async(id, code)
+      Thread.new do
         Thread.current.name = '__RBTrace__'
-        Thread.current[:output] = eval_context.eval(code).inspect
+        output = begin
+          eval_context.eval(code).inspect
+        rescue Exception => e
+          e.inspect
+        end
+        _send_result(id, output)
       end
-      t.join
-      t[:output]
+      nil
+    end
+
+    # Keep calls slower than threshold_ms in an in-memory flight recorder,
+    # without a client attached. Nothing is written until it is dumped.
+    def start_recorder(threshold_ms, seconds: 60, gc: false)
+      _recorder_start(threshold_ms, seconds, gc)
+    end
+
+    def stop_recorder
+      _recorder_start(0, 0, false)
+    end
+
+    # Write what the flight recorder has kept to path, in --slow format.
+    def dump_recorder(path = "/tmp/rbtrace-recorder-#{Process.pid}.log")
+      File.open(path, 'w') do |f|
+        recorder_entries.each do |type, start, duration, depth, name|
+          t = Time.at(start / 1_000_000, start % 1_000_000)
+          line = t.strftime('%H:%M:%S.%6N ') + '  ' * depth
+          if type == 'gc'
+            f.puts line + 'garbage_collect'
+          else
+            f.puts line + "#{name} <%f>" % (duration / 1_000_000.0)
+          end
+        end
+      end
+      path
+    end
+
+    # Count and time calls to methods matching selectors (as given to
+    # --methods), with or without a tracer attached, and serve the totals in
+    # prometheus' text format on a unix socket. "%p" in path is replaced with
+    # the pid, so forked children serve their own.
+    #
+    # Returns the path of the socket.
+    def start_metrics(selectors, path: '/tmp/rbtrace-metrics-%p.sock')
+      _metrics_start(path, Array(selectors))
+    end
+
+    def stop_metrics
+      _metrics_stop
     end
 
     private
@@ -20,3 +66,21 @@ module RBTrace
 end
 
 require 'rbtrace.so'
+
+# RBTRACE_RECORDER=<msec>[,<seconds>][,gc] starts the flight recorder on boot,
+# and RBTRACE_RECORDER_SIGNAL=<signal> dumps it to /tmp when received.
+if (recorder = ENV['RBTRACE_RECORDER'])
+  msec, seconds = recorder.split(',') - ['gc']
+  RBTrace.start_recorder(Integer(msec), seconds: Integer(seconds || 60), gc: recorder.end_with?(',gc'))
+
+  if (signal = ENV['RBTRACE_RECORDER_SIGNAL'])
+    trap(signal) { RBTrace.dump_recorder }
+  end
+end
+
+# RBTRACE_METRICS=<selector>[,<selector>...] serves metrics for them from boot,
+# on RBTRACE_METRICS_SOCKET if given.
+if (metrics = ENV['RBTRACE_METRICS'])
+  path = ENV['RBTRACE_METRICS_SOCKET']
+  RBTrace.start_metrics(metrics.split(/[\s,]+/).reject(&:empty?), **(path ? { path: path } : {}))
+end
@@ -0,0 +1,81 @@
+require 'json'
+
+class RBTracer
+  # Writes calls to a file in chrome's trace event format as they arrive, to
+  # open in chrome://tracing or perfetto. Each ruby thread gets a track of its
+  # own, and garbage collections one more. Only the names seen so far are
+  # kept, so a trace can grow as large as the disk allows.
+  class ChromeTrace
+    GC_TID = 0
+
+    def initialize(path, pid)
+      @out = File.open(path, 'w')
+      @pid = pid
+      @tids = {}
+      @names = {}
+      @sep = "[\n"
+
+      metadata('process_name', 0, "ruby #{pid}")
+      metadata('thread_name', GC_TID, 'gc')
+    end
+
+    def begin(name, time, thread)
+      event(%("name":#{json(name)},"ph":"B","ts":#{time},"tid":#{tid(thread)}))
+    end
+
+    def end(time, thread, cpu=nil)
+      event(%("ph":"E","ts":#{time},"tid":#{tid(thread)}#{args(cpu)}))
+    end
+
+    # A call that is only known once it returned, e.g. a slow one.
+    def complete(name, time, duration, thread, cpu=nil)
+      event(%("name":#{json(name)},"ph":"X","ts":#{time},"dur":#{duration},"tid":#{tid(thread)}#{args(cpu)}))
+    end
+
+    def gc_start(time)
+      event(%("name":"garbage_collect","ph":"B","ts":#{time},"tid":#{GC_TID}))
+    end
+
+    def gc_end(time)
+      event(%("ph":"E","ts":#{time},"tid":#{GC_TID}))
+    end
+
+    def gc(time)
+      event(%("name":"garbage_collect","ph":"i","s":"t","ts":#{time},"tid":#{GC_TID}))
+    end
+
+    def close
+      @out.write("\n]\n")
+      @out.close
+    end
+
+    private
+
+    def event(fields)
+      @out.write(%(#{@sep}{#{fields},"pid":#{@pid}}))
+      @sep = ",\n"
+    end
+
+    def metadata(kind, tid, name)
+      event(%("name":"#{kind}","ph":"M","tid":#{tid},"args":{"name":#{json(name)}}))
+    end
+
+    # Threads are numbered in the order they show up. Calls sent without
+    # one, e.g. by --tail, go on the first track.
+    def tid(thread)
+      @tids[thread] ||= begin
+        tid = @tids.size + 1
+        metadata('thread_name', tid, "thread #{tid}")
+        tid
+      end
+    end
+
+    def args(cpu)
+      cpu ? %(,"args":{"cpu_us":#{cpu}}) : ''
+    end
+
+    def json(name)
+      @names[name] ||= JSON.generate(name)
+    end
+  end
+end
@@ -51,8 +51,11 @@ class RBTraceCLI
   end
 
   def self.run
-    check_msgmnb
-    cleanup_queues
+    # linux uses a control socket instead of message queues
+    unless RUBY_PLATFORM =~ /linux/
+      check_msgmnb
+      cleanup_queues
+    end
 
     parser = Optimist::Parser.new do
       version <<-EOS
@@ -76,14 +79,22 @@ Usage:
   rbtrace --ps <CMD>       # look for running <CMD> processes to trace
 
   rbtrace -o <FILE>        # write output to file
+  rbtrace --chrome=<FILE>  # write calls to file for chrome://tracing or perfetto
   rbtrace -t               # show method call start time
   rbtrace -n               # hide duration of each method call
   rbtrace -r 3             # use 3 spaces to nest method calls
+  rbtrace --cputime        # show time on and off the cpu for each call
 
 Tracers:
 
   rbtrace --firehose       # trace all method calls
   rbtrace --slow=250       # trace method calls slower than 250ms
+  rbtrace --tail=250       # trace whole call trees slower than 250ms
+  rbtrace --adaptive=p99   # trace calls slower than their method's usual p99
+  rbtrace --gvl            # show time spent waiting for the GVL every second
+  rbtrace --io             # show time spent in blocking I/O every second
+  rbtrace -c activerecord --aggregate
+                           # show the queries with the most time spent every second
   rbtrace --methods a b c  # trace calls to given methods
   rbtrace --gc             # trace garbage collections
 
@@ -91,6 +102,21 @@ Tracers:
   rbtrace -c eventmachine  # trace common eventmachine functions
   rbtrace -c my.tracer     # trace all methods listed in my.tracer
 
+Before and After:
+
+  rbtrace --profile=60 --save=before.prof
+                           # sum up every call per method for 60 seconds
+  rbtrace --profile=60 --compare before.prof
+                           # profile again, and show the methods that changed
+  rbtrace --profile=60 --marker
+                           # profile until enter is pressed, then 60s more
+  rbtrace --compare before.prof after.prof
+
+Flight Recorder:
+
+  rbtrace --record=250     # keep recent calls slower than 250ms in memory
+  rbtrace --recorded       # show the calls kept since
+
 Method Selectors:
 
   sleep                    # any instance or class method named sleep
@@ -98,6 +124,8 @@ Method Selectors:
   Process.pid              # specific class method
   Dir.                     # any class methods in Dir
   Fixnum#                  # any instance methods of Fixnum
+  ActiveRecord::*#find_*   # glob over class and method names
+  /^Net::HTTP$/#/^req/     # regex over class and method names
 
 Trace Expressions:
 
@@ -107,6 +135,9 @@ Trace Expressions:
   method(self.attr)        # value of arbitrary ruby expression
   method(__source__)       # source file/line of callsite
 
+  values are cut down to --expr-length bytes in the process, and
+  --expr-rate and --expr-sample bound how often they are evaluated.
+
 
 All Options:\n
 
@@ -140,18 +171,116 @@ EOS
         :default => 250,
         :short => nil
 
+      opt :cputime,
+        "show each traced or slow call's cpu time (user and system, of its thread) and time off the cpu along with its wall time",
+        :short => nil
+
+      opt :sort,
+        "with --cputime, sum up the calls shown by method on exit, sorted by wall, cpu or off time",
+        :type => :string,
+        :short => nil
+
+      opt :tail,
+        "show complete call trees that took longer than N milliseconds, rooted at --methods or the outermost calls",
+        :type => :int,
+        :short => nil
+
+      opt :adaptive,
+        "watch for method calls slower than each method's own quantile (p99, p99.9) or multiple of its median (5x), learned over its first 100 calls. --slow sets a floor (default 1ms)",
+        :type => :string,
+        :short => nil
+
+      opt :gvl,
+        "show time threads spent waiting for the GVL, running and blocked, charged to --methods on their stack (ruby 3.3+)",
+        :short => nil
+
+      opt :io,
+        "show time spent in blocking I/O calls, by fd, path or peer and by calling method",
+        :short => nil
+
+      opt :aggregate,
+        "sum up calls to --methods or --config tracers in the process by their expressions' values with literals taken out, e.g. sql fingerprints",
+        :short => nil
+
+      opt :profile,
+        "sum up calls to --methods (or every method) in the process for N seconds, and show where the time went",
+        :type => :float,
+        :short => nil
+
+      opt :save,
+        "write the --profile window to FILE, to --compare against later",
+        :type => :string,
+        :short => nil
+
+      opt :compare,
+        "show methods whose latency or call rate changed from a window saved in FILE to --profile, or between two saved files",
+        :type => :strings,
+        :short => nil
+
+      opt :marker,
+        "with --profile, profile until enter is pressed (e.g. once a deploy is out), then for N more seconds, and compare the two",
+        :short => nil
+
+      opt :min_change,
+        "percent a method's mean latency or call rate must change by for --compare or --marker to show it",
+        :default => 10.0,
+        :short => nil
+
+      opt :top,
+        "number of fingerprints in each --aggregate report, or methods in a --profile report",
+        :default => 20,
+        :short => nil
+
+      opt :interval,
+        "seconds between --gvl, --io or --aggregate reports",
+        :default => 1.0,
+        :short => nil
+
       opt :slow_methods,
         "method(s) to restrict --slow to",
         :type => :strings
 
       opt :methods,
-        "method(s) to trace (valid formats: sleep String#gsub Process.pid Kernel# Dir.)",
+        "method(s) to trace (valid formats: sleep String#gsub Process.pid Kernel# Dir. Foo::*#find_* /^Foo/#/bar$/)",
         :type => :strings,
         :short => '-m'
 
+      opt :expr_length,
+        "bytes of each expression's value to keep, inspected piecewise where possible (0 for all)",
+        :default => 1024,
+        :short => nil
+
+      opt :expr_rate,
+        "evaluate each tracer's expressions at most this many times a second (0 for no limit)",
+        :default => 0,
+        :short => nil
+
+      opt :expr_sample,
+        "evaluate expressions on one in this many traced calls",
+        :default => 1,
+        :short => nil
+
       opt :gc,
         "trace garbage collections"
 
+      opt :record,
+        "keep calls slower than N milliseconds in an in-process flight recorder, which stays on after detaching (0 turns it off)",
+        :type => :int,
+        :short => nil
+
+      opt :record_seconds,
+        "seconds of history kept by the flight recorder",
+        :default => 60,
+        :short => nil
+
+      opt :record_gc,
+        "keep garbage collections in the flight recorder too",
+        :short => nil
+
+      opt :recorded,
+        "show what the flight recorder has kept",
+        :short => nil
+
       opt :start_time,
         "show start time for each method call",
         :short => '-t'
@@ -166,6 +295,11 @@ EOS
         :type => String,
         :short => '-o'
 
+      opt :chrome,
+        "write traced calls, slow calls and garbage collections to FILE in chrome's trace event format, with a track per thread, instead of printing them",
+        :type => String,
+        :short => nil
+
       opt :append,
         "append to output file instead of overwriting",
         :short => '-a'
@@ -243,12 +377,55 @@ EOS
       ARGV.clear
     end
 
-    unless %w[ fork eval interactive backtrace backtraces slow slowcpu firehose methods config gc memory heapdump].find{ |n| opts[:"#{n}_given"] }
-      $stderr.puts "Error: --slow, --slowcpu, --gc, --firehose, --methods, --interactive, --backtraces, --backtrace, --memory, --heapdump, --shapesdump or --config required."
+    unless %w[ fork eval interactive backtrace backtraces slow slowcpu adaptive gvl io tail firehose methods config gc memory heapdump record recorded profile compare].find{ |n| opts[:"#{n}_given"] }
+      $stderr.puts "Error: --slow, --slowcpu, --adaptive, --gvl, --io, --tail, --gc, --firehose, --methods, --interactive, --backtraces, --backtrace, --memory, --heapdump, --shapesdump, --record, --recorded, --profile, --compare or --config required."
       $stderr.puts "Try --help for help."
       exit(-1)
     end
 
+    if opts[:compare_given]
+      unless (1..2).cover?(opts[:compare].size)
+        parser.die :compare, '(takes one saved profile with --profile, or two without)'
+      end
+
+      begin
+        before, after = opts[:compare].map{ |path| RBTracer::Profile.load(path) }
+      rescue ArgumentError, SystemCallError => e
+        parser.die :compare, "(#{e.message})"
+      end
+
+      if after
+        parser.die :compare, '(cannot profile when comparing two saved profiles)' if opts[:profile_given]
+        before.report_diff(STDOUT, after, before.diff(after, opts[:min_change] / 100.0))
+        exit
+      elsif !opts[:profile_given]
+        parser.die :compare, '(needs --profile, or a second saved profile)'
+      end
+    end
+
+    if opts[:profile_given] && opts[:profile] <= 0
+      parser.die :profile, '(must be positive)'
+    end
+
+    if opts[:chrome_given]
+      if other = %w[ profile gvl io aggregate ].find{ |n| opts[:"#{n}_given"] }
+        parser.die :chrome, "(cannot be combined with --#{other})"
+      end
+    end
+
+    if opts[:sort_given]
+      parser.die :sort, '(needs --cputime)' unless opts[:cputime_given]
+      parser.die :sort, '(must be wall, cpu or off)' unless %w[ wall cpu off ].include?(opts[:sort])
+    end
+
+    if opts[:marker_given] && !opts[:profile_given]
+      parser.die :marker, '(needs --profile)'
+    end
+
+    if opts[:save_given] && !opts[:profile_given]
+      parser.die :save, '(needs --profile)'
+    end
+
     if opts[:fork_given] and opts[:pid].size != 1
       parser.die :fork, '(can only be invoked with one pid)'
     end
@@ -262,6 +439,24 @@ EOS
       end
     end
 
+    if opts[:adaptive_given]
+      case opts[:adaptive]
+      when /\Ap(\d+(?:\.\d+)?)\z/
+        adaptive = [($1.to_f * 10).round, 0]
+        parser.die :adaptive, '(quantile must be between p0.1 and p99.9)' unless adaptive[0].between?(1, 999)
+      when /\A(\d+)x\z/
+        adaptive = [500, $1.to_i]
+        parser.die :adaptive, '(multiplier must be at least 1x)' if adaptive[1] < 1
+      else
+        parser.die :adaptive, '(use a quantile like p99 or a multiple of the median like 5x)'
+      end
+    end
+
+    [:expr_length, :expr_rate].each do |opt|
+      parser.die opt, '(must not be negative)' if opts[opt] < 0
+    end
+    parser.die :expr_sample, '(must be at least 1)' if opts[:expr_sample] < 1
+
     methods, smethods = [], []
 
     if opts[:methods_given]
@@ -450,12 +645,15 @@ EOS
         num = opts[:backtraces].to_i
         num = -1 if num == 0
 
-        delim = "146621c9d681409aa"
+        # older rubies can't walk other threads' frames natively
+        unless tracer.backtraces(num)
+          delim = "146621c9d681409aa"
 
-        code = "Thread.list.reject { |t| t.name == '__RBTrace__' }.map{ |t| t.backtrace[0...#{num}].join(\"#{delim}\")}.join(\"#{delim*2}\")"
+          code = "Thread.list.reject { |t| t.name == '__RBTrace__' }.map{ |t| t.backtrace[0...#{num}].join(\"#{delim}\")}.join(\"#{delim*2}\")"
 
-        if res = tracer.eval(code)
-          tracer.puts res.split(delim).join("\n")
+          if res = tracer.eval(code)
+            tracer.puts res.split(delim).join("\n")
+          end
         end
 
       elsif opts[:memory_given]
@@ -543,6 +741,24 @@ EOS
         RUBY
         puts "Shapes dump being written to #{filename}"
 
+      elsif opts[:record_given] || opts[:recorded_given]
+        if opts[:record_given]
+          tracer.record(opts[:record], opts[:record_seconds], opts[:record_gc])
+          if opts[:record] > 0
+            STDERR.puts "*** flight recorder keeping calls slower than #{opts[:record]}ms over the last #{opts[:record_seconds]}s"
+          else
+            STDERR.puts "*** flight recorder turned off"
+          end
+        end
+
+        if opts[:recorded_given]
+          tracer.out = output if output
+          tracer.prefix = ' ' * opts[:prefix]
+          tracer.show_time = true
+          tracer.show_duration = !opts[:no_duration]
+          tracer.recorded
+        end
+
       elsif opts[:eval_given]
         if res = tracer.eval(code = opts[:eval])
           tracer.puts ">> #{code}"
@@ -573,20 +789,69 @@ EOS
 
         tracer.devmode if opts[:devmode_given]
         tracer.gc if opts[:gc_given]
-
-        if opts[:firehose_given]
+        tracer.cputime if opts[:cputime_given]
+        tracer.chrome_trace(opts[:chrome]) if opts[:chrome_given]
+        tracer.expr_limits(opts[:expr_length], opts[:expr_rate], opts[:expr_sample]) if methods.any? || smethods.any?
+
+        if opts[:profile_given]
+          tracer.profile
+          methods.any? ? tracer.add(methods) : tracer.firehose
+        elsif opts[:firehose_given]
           tracer.firehose
+        elsif opts[:gvl_given]
+          unless tracer.gvl
+            parser.die :gvl, '(the traced process needs ruby 3.3 or later)'
+          end
+          tracer.add(methods) if methods.any?
+        elsif opts[:io_given]
+          tracer.io
+        elsif opts[:aggregate_given]
+          parser.die :aggregate, '(needs --methods or --config)' if methods.empty?
+          tracer.aggregate(opts[:top])
+          tracer.add(methods)
+        elsif opts[:tail_given]
+          tracer.tail(opts[:tail])
+          tracer.add(methods) if methods.any?
         else
           tracer.add(methods)       if methods.any?
-          if opts[:slow_given] || opts[:slowcpu_given]
-            tracer.watch(opts[:slowcpu_given] ? opts[:slowcpu] : opts[:slow], opts[:slowcpu_given])
+          if opts[:slow_given] || opts[:slowcpu_given] || opts[:adaptive_given]
+            tracer.adaptive(*adaptive) if opts[:adaptive_given]
+            tracer.watch(opts[:slowcpu_given] ? opts[:slowcpu] : opts[:slow_given] ? opts[:slow] : 1, opts[:slowcpu_given])
             tracer.add_slow(smethods) if smethods.any?
           end
         end
         begin
-          tracer.recv_loop
+          if opts[:gvl_given]
+            tracer.recv_loop(opts[:interval]){ tracer.gvl_dump }
+          elsif opts[:io_given]
+            tracer.recv_loop(opts[:interval]){ tracer.io_dump }
+          elsif opts[:aggregate_given]
+            tracer.recv_loop(opts[:interval]){ tracer.aggregate_dump }
+          elsif opts[:profile_given]
+            if opts[:marker_given]
+              STDERR.puts "*** profiling, press enter at the marker"
+              STDIN.gets
+              before = tracer.profile_dump
+            end
+
+            STDERR.puts "*** profiling for #{opts[:profile]}s"
+            sleep opts[:profile]
+
+            if after = tracer.profile_dump
+              after.save(opts[:save]) if opts[:save_given]
+              if before
+                before.report_diff(tracer.out, after, before.diff(after, opts[:min_change] / 100.0))
+              else
+                after.report(tracer.out, opts[:top])
+              end
+            end
+          else
+            tracer.recv_loop
+          end
         rescue Interrupt, SignalException
         end
+
+        tracer.print_cputime(opts[:sort]) if opts[:sort_given]
       end
     ensure
       if tracer
@@ -12,12 +12,12 @@ module MsgQ
     layout :mtype, :long,
            :buf, [:char, BUF_SIZE]
 
-    def self.send_cmd(q, str)
+    def self.send_cmd(q, str, block=true)
       msg = EventMsg.new
       msg[:mtype] = 1
       msg[:buf].to_ptr.put_string(0, str)
 
-      ret = MsgQ.msgsnd(q, msg, BUF_SIZE, 0)
+      ret = MsgQ.msgsnd(q, msg, BUF_SIZE, block ? 0 : IPC_NOWAIT)
       FFI::LastError.raise if ret == -1
     end
 
@@ -0,0 +1,156 @@
+require 'msgpack'
+
+class RBTracer
+  # A window of calls summed up per method by the traced process: counts,
+  # total time and latency percentiles, all in usec.
+  class Profile
+    Stat = Struct.new(:count, :total, :p50, :p99, :max, :stddev) do
+      def mean
+        total.to_f / count
+      end
+    end
+
+    # A method whose latency or call rate changed between two windows, with
+    # how it changed, e.g. ['slower', 'fewer calls'].
+    Change = Struct.new(:name, :kinds, :before, :after, :impact)
+
+    # Calls a method needs in a window before its latency is compared.
+    MIN_CALLS = 10
+
+    # Calls are timed in usec, so means closer than this are just rounding,
+    # and no spread is taken to be smaller.
+    RESOLUTION = 1.0
+
+    # Standard errors a change must be away from zero to count, i.e. one in
+    # ~370 unchanged methods shows up by chance.
+    SIGNIFICANCE = 3.0
+
+    # Public: The Float length of the window in seconds.
+    attr_reader :interval
+
+    # Public: The Fixnum number of calls left out, with too many methods.
+    attr_reader :other
+
+    # Public: The Hash of method name to Stat.
+    attr_reader :stats
+
+    def initialize(interval, stats={}, other=0)
+      @interval = interval
+      @stats = stats
+      @other = other
+    end
+
+    # Read a window written by save.
+    #
+    # Returns a Profile.
+    def self.load(path)
+      data = MessagePack.unpack(File.binread(path))
+      stats = data['stats'].transform_values{ |s| Stat.new(*s) }
+      new(data['interval'], stats, data['other'])
+    rescue MessagePack::UnpackError, ArgumentError, NoMethodError, TypeError
+      raise ArgumentError, "#{path} is not a saved profile"
+    end
+
+    def save(path)
+      File.binwrite(path, {
+        'interval' => @interval,
+        'other' => @other,
+        'stats' => @stats.transform_values(&:to_a),
+      }.to_msgpack)
+    end
+
+    # Add up another method's calls under the same name.
+    #
+    # Returns nothing.
+    def add(name, stat)
+      if prev = @stats[name]
+        mean = (prev.total + stat.total).to_f / (prev.count + stat.count)
+        var = [prev, stat].sum{ |s| s.count * (s.stddev**2 + (s.mean - mean)**2) } / (prev.count + stat.count)
+        stat = Stat.new(prev.count + stat.count, prev.total + stat.total,
+          [prev.p50, stat.p50].max, [prev.p99, stat.p99].max, [prev.max, stat.max].max, Math.sqrt(var))
+      end
+      @stats[name] = stat
+    end
+
+    # Public: The methods that changed from this window to a later one, most
+    # time per second gained or lost first. Means are compared with Welch's
+    # t-test and call rates as poisson counts, and both must also have moved
+    # by at least min_change (a fraction) to be included.
+    #
+    # Returns an Array of Change.
+    def diff(after, min_change=0.1)
+      changes = []
+
+      (@stats.keys | after.stats.keys).each do |name|
+        a, b = @stats[name], after.stats[name]
+        impact = (b ? b.total / after.interval : 0) - (a ? a.total / @interval : 0)
+
+        if !a || !b
+          next if (a || b).count < MIN_CALLS
+          changes << Change.new(name, [a ? 'gone' : 'new'], a, b, impact)
+          next
+        end
+
+        kinds = []
+
+        if a.count >= MIN_CALLS && b.count >= MIN_CALLS && (b.mean - a.mean).abs >= RESOLUTION
+          mean_err = Math.sqrt([a.stddev, RESOLUTION].max**2 / a.count + [b.stddev, RESOLUTION].max**2 / b.count)
+          kinds << (b.mean > a.mean ? 'slower' : 'faster') if significant?(a.mean, b.mean, mean_err, min_change)
+        end
+
+        rate_a, rate_b = a.count / @interval, b.count / after.interval
+        rate_err = Math.sqrt(a.count / @interval**2 + b.count / after.interval**2)
+        kinds << (rate_b > rate_a ? 'more calls' : 'fewer calls') if significant?(rate_a, rate_b, rate_err, min_change)
+
+        changes << Change.new(name, kinds, a, b, impact) if kinds.any?
+      end
+
+      changes.sort_by{ |c| -c.impact.abs }
+    end
+
+    # Print the methods with the most time spent.
+    #
+    # Returns nothing.
+    def report(out, top=20)
+      out.puts "*** #{@stats.size} methods over #{'%.1f' % @interval}s"
+      out.puts "*** #{@other} calls were not counted, there were too many methods" if @other > 0
+      out.puts '%12s %10s %12s %12s %12s  %s' % %w[ total calls/s mean p99 max method ]
+      @stats.sort_by{ |_, s| -s.total }.first(top).each do |name, s|
+        out.puts '%12s %10.1f %12s %12s %12s  %s' % [secs(s.total), s.count / @interval,
+          secs(s.mean), secs([s.p99, s.max].min), secs(s.max), name]
+      end
+    end
+
+    # Print the changes from this window to a later one.
+    #
+    # Returns nothing.
+    def report_diff(out, after, changes, top=50)
+      out.puts "*** #{changes.size} of #{(@stats.keys | after.stats.keys).size} methods changed " \
+        "(before: #{'%.1f' % @interval}s, after: #{'%.1f' % after.interval}s)"
+      return if changes.empty?
+
+      out.puts '%12s  %-21s  %-25s  %-25s  %s' % ['time/s', 'calls/s', 'mean', 'p99', 'method']
+      changes.first(top).each do |c|
+        a, b = c.before, c.after
+        out.puts '%+12.6f  %-21s  %-25s  %-25s  %s (%s)' % [c.impact / 1_000_000.0,
+          "#{a ? '%.1f' % (a.count / @interval) : '-'} -> #{b ? '%.1f' % (b.count / after.interval) : '-'}",
+          "#{a ? secs(a.mean) : '-'} -> #{b ? secs(b.mean) : '-'}",
+          "#{a ? secs([a.p99, a.max].min) : '-'} -> #{b ? secs([b.p99, b.max].min) : '-'}",
+          c.name, c.kinds.join(', ')]
+      end
+      out.puts "*** #{changes.size - top} more" if changes.size > top
+    end
+
+    private
+
+    def secs(usec)
+      '%.6f' % (usec / 1_000_000.0)
+    end
+
+    def significant?(before, after, err, min_change)
+      delta = (after - before).abs
+      return false if delta <= before * min_change
+      err == 0 || delta / err >= SIGNIFICANCE
+    end
+  end
+end
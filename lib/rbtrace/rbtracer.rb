@@ -3,9 +3,13 @@ require 'fileutils'
 require 'msgpack'
 require 'ffi'
 require 'rbtrace/core_ext'
-require 'rbtrace/msgq'
+require 'rbtrace/profile'
+require 'rbtrace/chrome_trace'
 
 class RBTracer
+  # Seconds to wait for the process to answer our first signal.
+  READY_TIMEOUT = 1
+
   # Public: The Fixnum pid of the traced process.
   attr_reader   :pid
 
@@ -49,17 +53,23 @@ class RBTracer
     FileUtils.chmod 0666, socket_path
     at_exit { clean_socket_path }
 
-    5.times do
-      signal
-      sleep 0.15 # wait for process to create msgqs
+    # the process answers on our socket once it is ready for commands
+    @ready = false
+    @control = nil
+    signal
+    wait('for process to be ready', READY_TIMEOUT){ @ready }
 
+    if @ready && @has_control
+      @control = Socket.new Socket::AF_UNIX, Socket::SOCK_STREAM, 0
+      @control.connect(Socket.pack_sockaddr_un("\0rbtrace-#{@pid}"))
+    else
+      # no control socket on this platform, fall back to a msgq
+      require 'rbtrace/msgq'
       @qo = MsgQ.msgget(-@pid, 0666)
 
-      break if @qo > -1
-    end
-
-    if @qo == -1
-      raise ArgumentError, 'pid is not listening for messages, did you `require "rbtrace"`'
+      if @qo == -1
+        raise ArgumentError, 'pid is not listening for messages, did you `require "rbtrace"`'
+      end
     end
 
     @klasses = {}
@@ -74,6 +84,8 @@ class RBTracer
         :arglist => false
       }
     }
+    @pending_adds = []
+    @stacks = {}
     @max_nesting = @last_nesting = @nesting = 0
     @last_tracer = nil
 
@@ -88,6 +100,10 @@ class RBTracer
     @show_duration = true
     @watch_slow = false
 
+    @eval_id = 0
+    @eval_chunks = {}
+    @eval_done = {}
+
     attach
   end
 
@@ -109,6 +125,127 @@ class RBTracer
     send_cmd(cpu_only ? :watchcpu : :watch, msec)
   end
 
+  # Write calls to a file in chrome's trace event format as they arrive,
+  # with a track for each thread, instead of printing them.
+  #
+  # path - The String file to write to.
+  #
+  # Returns nothing.
+  def chrome_trace(path)
+    @chrome = ChromeTrace.new(path, @pid)
+    send_cmd(:threads)
+  end
+
+  # Send the cpu time (user and system, of the calling thread) along with
+  # the wall time of every slow or traced call, so time spent off the cpu
+  # waiting on i/o, locks or the GVL can be told apart.
+  #
+  # Returns nothing.
+  def cputime
+    @cpu_stats = {}
+    send_cmd(:cputime)
+  end
+
+  # Only report slow calls that are also slower than what is usual for their
+  # method, judged by a quantile or a multiple of the median of its durations.
+  #
+  # permille   - The Fixnum quantile, e.g. 990 for p99
+  # multiplier - The Fixnum multiple of the median to use instead, or 0
+  #
+  # Returns nothing.
+  def adaptive(permille, multiplier=0)
+    send_cmd(:adaptive, permille, multiplier)
+  end
+
+  # Show complete call trees, but only for roots slower than a threshold.
+  # Roots are the traced methods, or the outermost calls without any.
+  #
+  # msec - The Fixnum threshold in milliseconds
+  #
+  # Returns nothing.
+  def tail(msec)
+    send_cmd(:tail, msec)
+  end
+
+  # Follow threads through acquiring and releasing the GVL. Waits are charged
+  # to the innermost method added with #add on each thread's stack.
+  #
+  # Returns true, or false if the process's ruby is too old for it.
+  def gvl
+    @gvl_started = nil
+    send_cmd(:gvl)
+
+    if wait('for gvl mode', timeout){ !@gvl_started.nil? }
+      @gvl_started
+    else
+      STDERR.puts '*** timed out waiting for gvl mode'
+      false
+    end
+  end
+
+  # Aggregate time spent in blocking I/O calls, by fd/path/peer and caller.
+  #
+  # Returns nothing.
+  def io
+    send_cmd(:io)
+  end
+
+  # Print what io mode has seen since the previous dump.
+  #
+  # Returns nothing.
+  def io_dump
+    send_cmd(:iodump)
+  end
+
+  # Sum up calls to traced methods in the process, by a fingerprint of their
+  # expressions' values with literals taken out (e.g. execute(sql)), instead
+  # of sending every call.
+  #
+  # top - The Fixnum number of fingerprints to send with each dump.
+  #
+  # Returns nothing.
+  def aggregate(top=20)
+    send_cmd(:aggregate, top)
+  end
+
+  # Print the fingerprints with the most time spent since the previous dump.
+  #
+  # Returns nothing.
+  def aggregate_dump
+    send_cmd(:aggdump)
+  end
+
+  # Time calls to traced methods (or every method, with the firehose) and
+  # sum them up per method in the process, instead of sending every call.
+  #
+  # Returns nothing.
+  def profile
+    send_cmd(:profile)
+  end
+
+  # Collect what profile mode has seen since it started or the previous
+  # dump, and start a new window.
+  #
+  # Returns an RBTracer::Profile, or nil if the process did not answer.
+  def profile_dump
+    @profile = nil
+    @prof_stats = Profile.new(0)
+    send_cmd(:profdump)
+
+    if wait('for profile', timeout){ !!@profile }
+      @profile
+    else
+      STDERR.puts '*** timed out waiting for profile'
+    end
+  end
+
+  # Print what gvl mode has seen since the previous dump.
+  #
+  # Returns nothing.
+  def gvl_dump
+    send_cmd(:gvldump)
+  end
+
   # Turn on the firehose (show all method calls).
   #
   # Returns nothing.
@@ -139,21 +276,90 @@ class RBTracer
   #
   # Returns the String result.
   def eval(code)
+    eval_result(eval_async(code))
+  end
+
+  # Start evaluating some ruby code in its own thread in the process, without
+  # waiting for it. Several evals can be in flight at once.
+  #
+  # Returns the Fixnum id to pass to eval_result.
+  def eval_async(code)
     if (err = valid_syntax?(code)) != true
       raise ArgumentError, "#{err.class} for expression #{code.inspect}"
     end
 
-    send_cmd(:eval, code)
+    id = @eval_id += 1
+    @eval_chunks[id] = []
+    send_cmd(:aeval, id, code)
+    id
+  end
 
-    if wait('for eval response', timeout){ !!@eval_result }
-      res = @eval_result
-      @eval_result = nil
-      res
+  # Wait for an eval started with eval_async, however large its result is.
+  #
+  # Returns the String result.
+  def eval_result(id)
+    if wait('for eval response', timeout){ @eval_done.key?(id) }
+      @eval_done.delete(id)
+      @eval_chunks.delete(id).join
     else
       STDERR.puts '*** timed out waiting for eval response'
     end
   end
 
+  # Print the backtraces of all threads, as the process walks them.
+  #
+  # limit - The Fixnum number of frames per thread, or -1 for all of them.
+  #
+  # Returns the Fixnum number of threads, or nil if the process can't walk
+  # them itself (use eval instead) or timed out.
+  def backtraces(limit=-1)
+    @bt_done = nil
+    @bt_frames = {}
+    send_cmd(:backtraces, limit)
+
+    if wait('for backtraces', timeout){ !!@bt_done }
+      @bt_done if @bt_done >= 0
+    else
+      STDERR.puts '*** timed out waiting for backtraces'
+    end
+  end
+
+  # Keep slow calls in the process's flight recorder, attached or not.
+  #
+  # msec - The Fixnum threshold in milliseconds, or 0 to stop recording.
+  # seconds - The Fixnum number of seconds of history to keep.
+  # gc - The Boolean flag for also recording garbage collections.
+  #
+  # Returns nothing.
+  def record(msec, seconds=60, gc=false)
+    send_cmd(:record, msec, seconds, gc)
+  end
+
+  # Print what the flight recorder has kept, in --slow format.
+  #
+  # Returns the Fixnum number of events printed, or nil on a timeout.
+  def recorded
+    @recorded = nil
+    send_cmd(:recdump)
+
+    if wait('for flight recorder', timeout){ !!@recorded }
+      @recorded
+    else
+      STDERR.puts '*** timed out waiting for flight recorder'
+    end
+  end
+
+  # Bound what evaluating tracer expressions may cost the process.
+  #
+  # max_length - The Fixnum bytes of each value to keep, or 0 for all
+  # max_rate   - The Fixnum evaluations per second per tracer, or 0 for any
+  # sample     - The Fixnum to evaluate on one in this many calls
+  #
+  # Returns nothing.
+  def expr_limits(max_length, max_rate=0, sample=1)
+    send_cmd(:exprlimit, max_length, max_rate, sample)
+  end
+
   # Turn on GC tracing.
   #
   # Returns nothing.
@@ -172,35 +378,44 @@ class RBTracer
 
   # Add tracers for the given list of methods.
   #
+  # All tracers are sent to the process in a single command, however many
+  # there are.
+  #
   # methods - The String or Array of method selectors to trace.
   #
   # Returns nothing.
   def add(methods, slow=false)
+    entries = []
+
     Array(methods).each do |func|
       func = func.strip
       next if func.empty?
 
+      name, args = nil, nil
       if func =~ /^(.+?)\((.+)\)$/
         name, args = $1, $2
         args = args.split(',').map{ |a| a.strip }
       end
 
-      send_cmd(:add, name || func, slow)
-
-      if args and args.any?
-        args.each do |arg|
-          if (err = valid_syntax?(arg)) != true
-            raise ArgumentError, "#{err.class} for expression #{arg.inspect} in method #{func.inspect}"
-          end
-          if arg =~ /^@/ and arg !~ /^@[_a-z][_a-z0-9]+$/i
-            # arg[0]=='@' means ivar, but if this is an expr
-            # we can hack a space in front so it gets eval'd instead
-            arg = " #{arg}"
-          end
-          send_cmd(:addexpr, arg)
+      exprs = Array(args).map do |arg|
+        if (err = valid_syntax?(arg)) != true
+          raise ArgumentError, "#{err.class} for expression #{arg.inspect} in method #{func.inspect}"
         end
+        if arg =~ /^@/ and arg !~ /^@[_a-z][_a-z0-9]+$/i
+          # arg[0]=='@' means ivar, but if this is an expr
+          # we can hack a space in front so it gets eval'd instead
+          arg = " #{arg}"
+        end
+        arg
       end
+
+      entries << [name || func, slow, exprs]
     end
+
+    return if entries.empty?
+
+    @pending_adds << entries
+    send_cmd(:addall, entries)
   end
 
   # Attach to the process.
@@ -242,12 +457,16 @@ class RBTracer
     retry
   ensure
     clean_socket_path
+    @chrome.close if @chrome
+    @chrome = nil
   end
 
   # Process events from the traced process.
   #
   # Returns nothing
-  def recv_loop
+  def recv_loop(every=nil)
+    tick = every && Process.clock_gettime(Process::CLOCK_MONOTONIC) + every
+
     while true
       ready = IO.select([@sock], nil, nil, 1)
 
@@ -260,6 +479,11 @@ class RBTracer
         Process.kill(0, @pid)
       end
 
+      # run the block every so many seconds
+      if tick && Process.clock_gettime(Process::CLOCK_MONOTONIC) >= tick
+        tick += every
+        yield
+      end
     end
   rescue Errno::EINVAL, Errno::EIDRM, Errno::ESRCH
     # process went away
@@ -282,58 +506,192 @@ class RBTracer
     arg ? @out.puts(arg) : @out.puts
   end
 
+  # Print the calls shown so far with their cpu time, summed up by method.
+  #
+  # sort - The String column to sort by: wall, cpu or off.
+  #
+  # Returns nothing.
+  def print_cputime(sort='wall', top=20)
+    stats = (@cpu_stats || {}).map{ |name, (count, wall, cpu)| [name, count, wall, cpu, [wall - cpu, 0].max] }
+    column = { 'wall' => 2, 'cpu' => 3, 'off' => 4 }.fetch(sort)
+
+    newline
+    puts "*** #{stats.size} methods by #{sort} time"
+    return if stats.empty?
+
+    puts '%8s %12s %12s %12s  %s' % %w[ calls wall cpu off method ]
+    stats.sort_by{ |s| -s[column] }.first(top).each do |name, count, wall, cpu, off|
+      puts '%8d %12s %12s %12s  %s' % [count, secs(wall), secs(cpu), secs(off), name]
+    end
+  end
+
   private
 
   def signal
     Process.kill 'URG', @pid
   end
 
+  # Upper bound of the bucket a quantile falls into, from the non-empty
+  # buckets of a histogram.
+  def quantile(bounds, counts, q)
+    rank, seen = (q * counts.sum).ceil, 0
+    bounds.zip(counts).each{ |bound, count| return bound if (seen += count) >= rank }
+    0
+  end
+
+  def secs(usec)
+    '%.6f' % (usec / 1_000_000.0)
+  end
+
+  # Formats a call's duration, with its time on and off the cpu if known,
+  # and keeps count of them for print_cputime.
+  def duration(name, wall, cpu)
+    return '%f' % (wall/1_000_000.0) unless cpu
+
+    stat = (@cpu_stats ||= {})[name] ||= [0, 0, 0]
+    stat[0] += 1
+    stat[1] += wall
+    stat[2] += cpu
+    '%f cpu=%f off=%f' % [wall/1_000_000.0, cpu/1_000_000.0, [wall - cpu, 0].max/1_000_000.0]
+  end
+
+  def print_gvl(interval)
+    newline
+    puts "*** gvl over the last #{secs(interval)}s"
+    puts '%-10s %8s %12s %12s %12s %12s' % %w[ state count total p50 p99 max ]
+    (@gvl_hists || []).each do |kind, count, total, bounds, counts|
+      next puts('%-10s %8d' % [kind, 0]) if count == 0
+      puts '%-10s %8d %12s %12s %12s %12s' % [kind, count, secs(total),
+        secs(quantile(bounds, counts, 0.5)), secs(quantile(bounds, counts, 0.99)), secs(bounds.last)]
+    end
+
+    (@gvl_threads || []).sort_by{ |_, wait| -wait }.each do |desc, wait, run, blocked|
+      puts "#{@prefix}#{desc} wait=#{secs(wait)} run=#{secs(run)} blocked=#{secs(blocked)}"
+    end
+
+    (@gvl_methods || []).sort_by{ |_, wait| -wait }.each do |name, wait, count|
+      puts "#{@prefix}#{name} waited #{secs(wait)} over #{count} acquisitions"
+    end
+    puts
+
+    @gvl_hists = @gvl_threads = @gvl_methods = nil
+  end
+
+  def print_aggregate(num, other, interval)
+    stats = @agg_stats || []
+    @agg_stats = nil
+
+    newline
+    puts "*** top #{stats.size} of #{num} fingerprints over the last #{secs(interval)}s"
+    STDERR.puts "*** #{other} calls were not counted, there were too many fingerprints" if other > 0
+    return puts if stats.empty?
+
+    puts '%12s %8s %12s %12s %12s  %s' % %w[ total count p50 p99 max call ]
+    stats.each do |tracer_id, fingerprint, count, total, p50, p99, max|
+      query = @tracers[tracer_id][:query] || '(removed)'
+      puts '%12s %8d %12s %12s %12s  %s' % [secs(total), count,
+        secs([p50, max].min), secs([p99, max].min), secs(max), fingerprint.empty? ? query : "#{query} #{fingerprint}"]
+    end
+    puts
+  end
+
+  def print_io(interval)
+    stats = @io_stats || []
+    @io_stats = nil
+
+    newline
+    puts "*** io over the last #{secs(interval)}s: #{stats.sum{ |s| s[:count] }} calls blocked for #{secs(stats.sum{ |s| s[:total] })}s"
+    return puts if stats.empty?
+
+    puts '%12s %8s %12s %12s %12s  %s' % %w[ total count p50 p99 max call ]
+    stats.sort_by{ |s| -s[:total] }.first(10).each do |s|
+      puts '%12s %8d %12s %12s %12s  %s on %s%s' % [secs(s[:total]), s[:count],
+        secs([quantile(s[:bounds], s[:counts], 0.5), s[:max]].min),
+        secs([quantile(s[:bounds], s[:counts], 0.99), s[:max]].min), secs(s[:max]),
+        s[:name], s[:target], s[:caller] ? " from #{s[:caller]}" : '']
+    end
+
+    { :target => 'by target', :caller => 'by caller' }.each do |key, title|
+      puts "#{@prefix}#{title}:"
+      stats.group_by{ |s| s[key] || '(unknown)' }.map{ |k, group|
+        [k, group.sum{ |s| s[:total] }, group.sum{ |s| s[:count] }]
+      }.sort_by{ |_, total| -total }.first(10).each do |k, total, count|
+        puts "#{@prefix*2}#{secs(total)}s over #{count} calls  #{k}"
+      end
+    end
+    puts
+  end
+
   # Process incoming events until either a timeout or a condition becomes true.
   #
   # time - The Fixnum timeout in seconds.
-  # block - The Block that is checked every 50ms until it returns true.
+  # block - The Block that is checked whenever events arrive until it returns true.
   #
   # Returns true when the condition was met, or false on a timeout.
-  def wait(reason, time=@timeout)
-    wait = 0.05 # polling interval
+  def wait(reason, time=(@timeout || 5))
+    deadline = Process.clock_gettime(Process::CLOCK_MONOTONIC) + time
+
+    until yield
+      left = deadline - Process.clock_gettime(Process::CLOCK_MONOTONIC)
+      return false if left <= 0
 
-    (time/wait).to_i.times do
       begin
-        recv_lines
-        sleep(wait)
-        begin
-          signal
-        rescue Errno::ESRCH
-          break
+        # block on the socket, but check on the process at least every second
+        if IO.select([@sock], nil, nil, [left, 1].min)
+          recv_lines
+        else
+          Process.kill(0, @pid)
         end
-        time -= wait
-
-        return true if yield
+      rescue Errno::ESRCH
+        return false
       rescue Interrupt
-        STDERR.puts "*** waiting #{reason} (#{time.to_i}s left)"
-        retry
+        STDERR.puts "*** waiting #{reason} (#{left.to_i}s left)"
       end
     end
 
-    false
+    true
   end
 
   def send_cmd(*cmd)
-    begin
-      msg = cmd.to_msgpack
-      # A message is null-terminated, but bytesize gives the unterminated
-      # length.
-      if msg.bytesize >= RBTrace::BUF_SIZE
-        raise ArgumentError, "command is too long (#{msg.bytesize}B >= #{MsgQ::EventMsg::BUF_SIZE}B)"
+    msg = cmd.to_msgpack
+
+    # The control socket takes length-prefixed messages of any size. On a
+    # msgq, a message is null-terminated, but bytesize gives the unterminated
+    # length. Anything larger is split up and reassembled by the tracee.
+    if @control
+      send_msg([msg.bytesize].pack('N') << msg)
+    elsif msg.bytesize >= RBTrace::BUF_SIZE
+      chunk = RBTrace::BUF_SIZE - 32
+      0.step(msg.bytesize - 1, chunk) do |offset|
+        send_msg([:frag, msg.bytesize, msg.byteslice(offset, chunk)].to_msgpack)
       end
-      MsgQ::EventMsg.send_cmd(@qo, msg)
-    rescue Errno::EINTR
-      retry
+    else
+      send_msg(msg)
     end
+
     signal
     recv_lines
   end
 
+  def send_msg(msg)
+    if @control
+      @control.write(msg)
+    else
+      MsgQ::EventMsg.send_cmd(@qo, msg, false)
+    end
+  rescue Errno::EPIPE, Errno::ECONNRESET
+    # the process went away along with its end of the control socket
+    raise Errno::ESRCH
+  rescue Errno::EINTR
+    retry
+  rescue Errno::EAGAIN
+    # the queue is full, so let the tracee drain it
+    signal
+    recv_lines
+    sleep 0.001
+    retry
+  end
+
   def recv_cmd(block=true)
     if block
       @sock.recv(65536)
@@ -376,11 +734,123 @@ class RBTracer
     event = cmd.shift
 
     case event
+    when 'ready'
+      _, @has_control = *cmd
+      @ready = true
+      return
+
     when 'during_gc'
       sleep 0.01
       signal
       return
 
+    when 'recorded'
+      @recorded, = *cmd
+      newline
+      STDERR.puts "*** #{@recorded} events in the flight recorder"
+      return
+
+    when 'gvlstarted'
+      @gvl_started, = *cmd
+      return
+
+    when 'gvlhist'
+      kind, count, total, bounds, counts = *cmd
+      @gvl_hists ||= []
+      @gvl_hists << [kind, count, total, bounds, counts]
+      return
+
+    when 'gvlthread'
+      desc, wait, run, blocked = *cmd
+      (@gvl_threads ||= []) << [desc, wait, run, blocked]
+      return
+
+    when 'gvlmethod'
+      mid, is_singleton, klass, wait, count = *cmd
+      klass = @klasses[klass]
+      name = klass ? "#{klass}#{ is_singleton ? '.' : '#' }" : ''
+      name += @methods[mid] || '(unknown)'
+      (@gvl_methods ||= []) << [name, wait, count]
+      return
+
+    when 'gvldone'
+      interval, = *cmd
+      print_gvl(interval)
+      return
+
+    when 'iostat'
+      target, mid, is_singleton, klass, caller, total, max, bounds, counts = *cmd
+      klass = @klasses[klass]
+      name = klass ? "#{klass}#{ is_singleton ? '.' : '#' }" : ''
+      name += @methods[mid] || '(unknown)'
+      caller = nil if caller.empty?
+      (@io_stats ||= []) << { :target => target, :name => name, :caller => caller, :total => total,
+        :max => max, :count => counts.sum, :bounds => bounds, :counts => counts }
+      return
+
+    when 'aggstat'
+      tracer_id, fingerprint, count, total, p50, p99, max = *cmd
+      (@agg_stats ||= []) << [tracer_id, fingerprint, count, total, p50, p99, max]
+      return
+
+    when 'aggdone'
+      num, other, interval = *cmd
+      print_aggregate(num, other, interval)
+      return
+
+    when 'profstat'
+      mid, is_singleton, klass, *stat = *cmd
+      klass = @klasses[klass]
+      name = klass ? "#{klass}#{ is_singleton ? '.' : '#' }" : ''
+      name += @methods[mid] || '(unknown)'
+      @prof_stats.add(name, Profile::Stat.new(*stat)) if @prof_stats
+      return
+
+    when 'profdone'
+      num, other, interval = *cmd
+      @profile = Profile.new(interval / 1_000_000.0, @prof_stats ? @prof_stats.stats : {}, other)
+      @prof_stats = nil
+      return
+
+    when 'iodone'
+      interval, = *cmd
+      print_io(interval)
+      return
+
+    when 'btthread'
+      num, desc = *cmd
+      puts if num > 0
+      puts desc
+      return
+
+    when 'btframe'
+      id, path, label = *cmd
+      @bt_frames[id] = [path, label]
+      return
+
+    when 'btframes'
+      num, ids, lines = *cmd
+      ids.zip(lines) do |id, line|
+        path, label = @bt_frames[id]
+        puts path.empty? ? label : "#{path}:#{line}:in `#{label}'"
+      end
+      return
+
+    when 'btdone'
+      @bt_done, = *cmd
+      return
+
+    when 'truncated'
+      num, = *cmd
+      newline
+      STDERR.puts "*** left out #{num} calls from the tree above, it was too large to buffer or send"
+      return
+
+    when 'dropped'
+      num, = *cmd
+      STDERR.puts "*** dropped #{num} events, the process is producing them faster than we can read"
+      return
+
     when 'attached'
       tracer_pid, = *cmd
       if tracer_pid != Process.pid
@@ -412,9 +882,17 @@ class RBTracer
       pid, = *cmd
       @forked_pid = pid
 
-    when 'evaled'
-      res, = *cmd
-      @eval_result = res
+    when 'evalchunk'
+      id, seq, data = *cmd
+      @eval_chunks[id][seq] = data if @eval_chunks[id]
+
+    when 'evaldone'
+      id, num = *cmd
+      if (chunks = @eval_chunks[id])
+        STDERR.puts "*** parts of an eval result were lost" if chunks.size != num || chunks.include?(nil)
+        chunks.map!(&:to_s)
+        @eval_done[id] = true
+      end
 
     when 'mid'
       mid, name = *cmd
@@ -433,6 +911,26 @@ class RBTracer
         @tracers[tracer_id][:query] = query
       end
 
+    when 'added'
+      offset, tracer_ids = *cmd
+      entries = @pending_adds.first
+
+      tracer_ids.each_with_index do |tracer_id, i|
+        query, _, exprs = entries[offset + i]
+
+        if tracer_id == -1
+          STDERR.puts "*** unable to add tracer for #{query}"
+        else
+          @tracers.delete(tracer_id)
+          @tracers[tracer_id][:query] = query
+          exprs.each_with_index do |expr, expr_id|
+            @tracers[tracer_id][:exprs][expr_id] = expr.strip
+          end
+        end
+      end
+
+      @pending_adds.shift if offset + tracer_ids.size >= entries.size
+
     when 'newexpr'
       tracer_id, expr_id, expr = *cmd
       tracer = @tracers[tracer_id]
@@ -443,6 +941,7 @@ class RBTracer
 
     when 'exprval'
       tracer_id, expr_id, val = *cmd
+      return if @chrome
 
       tracer = @tracers[tracer_id]
       expr = tracer[:exprs][expr_id]
@@ -458,12 +957,13 @@ class RBTracer
       tracer[:arglist] = true
 
     when 'call','ccall'
-      time, tracer_id, mid, is_singleton, klass = *cmd
+      time, tracer_id, mid, is_singleton, klass, thread = *cmd
 
       tracer = @tracers[tracer_id]
       klass = @klasses[klass]
       name = klass ? "#{klass}#{ is_singleton ? '.' : '#' }" : ''
       name += @methods[mid] || '(unknown)'
+      return @chrome.begin(name, time, thread) if @chrome
 
       tracer[:times] << time
       tracer[:names] << name
@@ -488,7 +988,8 @@ class RBTracer
       tracer[:last] = "#{name}:#{@nesting-1}"
 
     when 'return','creturn'
-      time, tracer_id = *cmd
+      time, tracer_id, cpu, thread = *cmd
+      return @chrome.end(time, thread, @cpu_stats && cpu) if @chrome
       tracer = @tracers[tracer_id]
 
       @nesting -= 1 if @nesting > 0
@@ -506,7 +1007,7 @@ class RBTracer
           print @prefix*@nesting if @nesting > 0
           print name
         end
-        print ' <%f>' % (diff/1_000_000.0) if @show_duration
+        print ' <%s>' % duration(name, diff, cpu) if @show_duration
         newline
 
         if @nesting == 0 and @max_nesting > 1
@@ -519,12 +1020,18 @@ class RBTracer
       tracer[:arglist] = false
       @last_nesting = @nesting
 
+    when 'stack'
+      stack_id, frames = *cmd
+      @stacks[stack_id] = frames.split("\n")
+      return
+
     when 'slow', 'cslow'
-      time, diff, nesting, mid, is_singleton, klass = *cmd
+      time, diff, nesting, mid, is_singleton, klass, stack_id, expected, cpu, thread = *cmd
 
       klass = @klasses[klass]
       name = klass ? "#{klass}#{ is_singleton ? '.' : '#' }" : ''
       name += @methods[mid] || '(unknown)'
+      return @chrome.complete(name, time, diff, thread, @cpu_stats && cpu) if @chrome
 
       newline
       nesting = @nesting if @nesting > 0
@@ -539,9 +1046,16 @@ class RBTracer
       print name
       if @show_duration
         print ' '
-        print "<%f>" % (diff/1_000_000.0)
+        print "<%s>" % duration(name, diff, cpu)
+        print " (usually under <%f>)" % (expected/1_000_000.0) if expected && expected > 0
       end
       puts
+
+      if frames = @stacks[stack_id]
+        indent = (@show_time ? ' '*16 : '') + @prefix*(nesting+1)
+        frames.each{ |frame| puts "#{indent}from #{frame}" }
+      end
+
       puts if nesting == 0 and @max_nesting > 1
 
       @max_nesting = nesting if nesting > @max_nesting
@@ -549,11 +1063,13 @@ class RBTracer
 
     when 'gc_start'
       time, = *cmd
+      return @chrome.gc_start(time) if @chrome
       @gc_start = time
       print 'garbage_collect'
 
     when 'gc_end'
       time, = *cmd
+      return @chrome.gc_end(time) if @chrome
       diff = time - @gc_start
       # if @gc_mark
       #   mark = ((@gc_mark - @gc_start) * 100.0 / diff).to_i
@@ -565,6 +1081,7 @@ class RBTracer
 
     when 'gc'
       time, = *cmd
+      return @chrome.gc(time) if @chrome
       @gc_mark = time
 
       unless @gc_start
@@ -1,4 +1,5 @@
 require 'rbtrace'
+require 'socket'
 require 'tmpdir'
 
 class String
@@ -25,6 +26,9 @@ end
   end
 }).call
 
+pipe_r, pipe_w = IO.pipe
+sock_a, sock_b = UNIXSocket.pair
+
 while true
   proc {
     Dir.mktmpdir do |tmp|
@@ -35,6 +39,11 @@ while true
         sleep rand*0.5
 
         ENV['blah']
+
+        pipe_w.write('ping')
+        pipe_r.read(4)
+        sock_a.send('pong', 0)
+        sock_b.recv(4)
         GC.start
 
         reload_test.call
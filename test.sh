@@ -36,21 +36,52 @@ trace -m Test.run --devmode
 trace -m sleep
 trace -m sleep Dir.chdir Dir.pwd Process.pid "String#gsub" "String#*"
 trace -m "Kernel#"
+trace -m "Dir.*d*" "/^Str.ng$/#/^(gsub|multiply_.*)$/"
+trace -m "/^Te/./^ru/" --devmode
 trace -m "String#gsub(self,@test)" "String#*(self,__source__)" "String#multiply_vowels(self,self.length,num)"
+trace -m "String#multiply_vowels(self)" --expr-length=3 --expr-rate=5 --expr-sample=2
 trace -e 'p(1 + 1)'
+trace -e '(1..100000).map(&:to_s)'
+trace --backtraces
 trace -h
 trace --gc --slow=200
 trace --gc -m Dir.
 trace --slow=250
 trace --slow=250 --slow-methods sleep
+trace --slow=250 --cputime
+trace -m sleep Dir.chdir --cputime --sort=off
+trace --adaptive=p99
+trace --adaptive=5x --slow=100
+trace --gvl
+trace --gvl -m sleep
+trace --io
+trace --tail=250
+trace --tail=250 -m Dir.chdir
 trace --gc -m Dir. --slow=250 --slow-methods sleep
 trace --gc -m Dir. --slow=250
 trace -m Process. Dir.pwd "Proc#call"
+ruby -e 'puts (1..2000).map{ |i| "String#meth_#{i}" }, "Kernel#sleep"' > bulk.tracer
+trace -c bulk.tracer
+trace --aggregate -m "String#gsub(self)"
+rm -f bulk.tracer
+trace --profile=1 --save=before.prof
+trace --profile=1 -m sleep Dir.chdir --compare before.prof
+rm -f before.prof
 trace --firehose
+trace --firehose --gc --chrome=trace.json
+rm -f trace.json
+trace --record=250 --record-gc
+trace --recorded
+trace --record=0
 
 echo ------------------------------------------
 echo interactive irb output
 echo ------------------------------------------
 bundle exec ruby test/interactive_irb_test.rb $PID
 
+echo ------------------------------------------
+echo metrics endpoint
+echo ------------------------------------------
+bundle exec ruby test/metrics_test.rb
+
 cleanup
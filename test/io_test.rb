@@ -0,0 +1,47 @@
+# frozen_string_literal: true
+#
+# traces the blocking I/O of a process that appends to a string from inside
+# IO#each_line, and checks the outer call is still the one that is timed.
+#
+# usage: ruby test/io_test.rb
+
+require "rbconfig"
+
+code = <<~RUBY
+  require "rbtrace"
+  r, w = IO.pipe
+  loop do
+    w.write("a\\nb\\nc\\n")
+    w.flush
+    buf = +""
+    r.each_line { |line| buf << line; break if buf.size >= 6 }
+    sleep 0.01
+  end
+RUBY
+
+tracee = spawn(RbConfig.ruby, "-Ilib", "-Iext", "-e", code)
+failures = []
+
+begin
+  sleep 1
+  out = IO.popen([RbConfig.ruby, "-Ilib", "-Iext", "bin/rbtrace", "-p", tracee.to_s, "--io"], err: [:child, :out]) do |io|
+    sleep 2.5
+    Process.kill("INT", io.pid)
+    io.read
+  end
+
+  failures << "nothing was collected" unless out.include?("*** io over the last")
+  failures << "IO#each_line was not timed" unless out =~ /IO#each_line on fd \d+ \(pipe\)/
+  failures << "String#<< was timed" if out.include?("String#<<")
+ensure
+  Process.kill("TERM", tracee)
+  Process.wait(tracee)
+end
+
+if failures.empty?
+  puts "PASS: the outer IO call was timed"
+else
+  warn "FAIL: #{failures.join(', ')}"
+  warn out if defined?(out) && out
+  exit 1
+end
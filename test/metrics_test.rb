@@ -0,0 +1,81 @@
+# frozen_string_literal: true
+#
+# scrapes the metrics socket of a process started with RBTRACE_METRICS, the
+# way prometheus would, and checks the counts and histograms add up.
+#
+# usage: ruby test/metrics_test.rb
+
+require "socket"
+require "timeout"
+
+path = "/tmp/rbtrace-metrics-test-#{Process.pid}.sock"
+code = <<~RUBY
+  class Worker
+    def work; sleep 0.002; end
+    def self.batch; 3.times { new.work }; end
+  end
+  loop { Worker.batch; "a,b".split(",") }
+RUBY
+
+tracee = spawn({ "RBTRACE_METRICS" => "Worker#work,Worker.batch,String#spl*",
+                 "RBTRACE_METRICS_SOCKET" => path },
+               RbConfig.ruby, "-Ilib", "-Iext", "-rrbtrace", "-e", code)
+
+def scrape(path, request = nil)
+  UNIXSocket.open(path) do |sock|
+    sock.write(request) if request
+    sock.close_write
+    sock.read
+  end
+end
+
+failures = []
+
+begin
+  Timeout.timeout(10) { sleep 0.1 until File.socket?(path) }
+  sleep 1
+
+  plain = scrape(path)
+  http = scrape(path, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n")
+
+  failures << "no http status line" unless http.start_with?("HTTP/1.0 200 OK\r\n")
+  failures << "no content type" unless http.include?("Content-Type: text/plain; version=0.0.4")
+
+  calls = plain.scan(/^rbtrace_calls_total\{method="(.+?)",selector="(.+?)"\} (\d+)$/)
+               .to_h { |method, selector, n| [[method, selector], Integer(n)] }
+
+  work = calls[["Worker#work", "Worker#work"]].to_i
+  batch = calls[["Worker.batch", "Worker.batch"]].to_i
+  split = calls[["String#split", "String#spl*"]].to_i
+
+  failures << "Worker#work was not counted" unless work > 0
+  failures << "Worker.batch was not counted" unless batch > 0
+  failures << "String#split was not counted by pattern" unless split > 0
+  failures << "Worker#work counted #{work} times for #{batch} batches" unless work.between?(3 * batch - 3, 3 * batch + 3)
+
+  buckets = plain.scan(/^rbtrace_call_duration_seconds_bucket\{method="Worker#work",selector="Worker#work",le="(.+?)"\} (\d+)$/)
+  counts = buckets.map { |_, n| Integer(n) }
+  count = plain[/^rbtrace_call_duration_seconds_count\{method="Worker#work",selector="Worker#work"\} (\d+)$/, 1].to_i
+  sum = plain[/^rbtrace_call_duration_seconds_sum\{method="Worker#work",selector="Worker#work"\} (\S+)$/, 1].to_f
+
+  failures << "buckets are not cumulative" unless counts == counts.sort
+  failures << "last bucket is not +Inf" unless buckets.last && buckets.last[0] == "+Inf"
+  failures << "count does not match the +Inf bucket" unless count == counts.last
+  failures << "sleeps of 2ms fell into the wrong buckets" unless buckets.find { |le, _| le == "0.001" }[1].to_i == 0
+  failures << "sum of #{sum}s is off for #{count} sleeps of 2ms" unless count > 0 && (sum / count).between?(0.002, 0.05)
+rescue Timeout::Error, SystemCallError => e
+  failures << "could not scrape #{path}: #{e.class}"
+ensure
+  Process.kill("TERM", tracee)
+  Process.wait(tracee)
+end
+
+failures << "socket was left behind" if File.exist?(path)
+
+if failures.empty?
+  puts "PASS: metrics were served and add up"
+else
+  warn "FAIL: #{failures.join(', ')}"
+  warn plain if defined?(plain) && plain
+  exit 1
+end